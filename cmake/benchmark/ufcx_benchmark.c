@@ -0,0 +1,416 @@
+// Copyright (C) 2022 FEniCS Project
+//
+// This file is part of FFCx. (https://www.fenicsproject.org)
+//
+// SPDX-License-Identifier:    LGPL-3.0-or-later
+//
+// Micro-benchmark for the tabulate_tensor kernels of a compiled form.
+//
+// Usage: ufcx_benchmark [-n calls] library form
+//
+// Loads the ufcx_form variable <form> from the shared library <library>
+// (e.g. built from the code generated by ffcx), and times every
+// tabulate_tensor kernel of every integral of the form over <calls>
+// calls. The inputs are random: coefficients and constants are uniform
+// in [0, 1), the cell geometry is a random affine image of the
+// reference cell, and facet integrals get random local facet indices
+// and facet permutations. The calls cycle through a number of input
+// sets, so that the inputs are not all in registers.
+//
+// For each kernel the time per call, the achieved bandwidth (counting
+// the element tensor twice and the inputs once) and, if the flop count
+// is known, the achieved GFLOP/s are reported. The sizes of the inputs
+// and the flop count are taken from the ufcx_integral.
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <complex.h>
+#include <dlfcn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <ufcx.h>
+#include <unistd.h>
+
+// Number of input sets the calls cycle through
+#define NUM_SETS 64
+
+enum real_type
+{
+  real_float,
+  real_double,
+  real_longdouble
+};
+
+static const size_t real_size[] = {sizeof(float), sizeof(double), sizeof(long double)};
+
+// xorshift64* generator, seeded for reproducible inputs
+static unsigned long long rng_state = 0x9e3779b97f4a7c15ull;
+
+static double random_uniform(void)
+{
+  rng_state ^= rng_state >> 12;
+  rng_state ^= rng_state << 25;
+  rng_state ^= rng_state >> 27;
+  return (double)((rng_state * 0x2545f4914f6cdd1dull) >> 11) * 0x1.0p-53;
+}
+
+static void set_real(void* x, enum real_type type, size_t i, double value)
+{
+  switch (type)
+  {
+  case real_float:
+    ((float*)x)[i] = (float)value;
+    break;
+  case real_double:
+    ((double*)x)[i] = value;
+    break;
+  case real_longdouble:
+    ((long double*)x)[i] = value;
+    break;
+  }
+}
+
+// Fill n real values with random numbers in [0, 1)
+static void fill_random(void* x, enum real_type type, size_t n)
+{
+  for (size_t i = 0; i < n; ++i)
+    set_real(x, type, i, random_uniform());
+}
+
+static int num_vertices(ufcx_shape shape)
+{
+  switch (shape)
+  {
+  case interval:
+    return 2;
+  case triangle:
+    return 3;
+  case quadrilateral:
+  case tetrahedron:
+    return 4;
+  case prism:
+    return 6;
+  case pyramid:
+    return 5;
+  case hexahedron:
+    return 8;
+  default:
+    return 1;
+  }
+}
+
+static int num_facets(ufcx_shape shape)
+{
+  switch (shape)
+  {
+  case interval:
+    return 2;
+  case triangle:
+    return 3;
+  case quadrilateral:
+  case tetrahedron:
+    return 4;
+  case prism:
+  case pyramid:
+    return 5;
+  case hexahedron:
+    return 6;
+  default:
+    return 1;
+  }
+}
+
+// Number of rotations and reflections of a facet
+static int num_facet_permutations(ufcx_shape shape)
+{
+  switch (shape)
+  {
+  case triangle:
+  case quadrilateral:
+    return 2;
+  case tetrahedron:
+    return 6;
+  case hexahedron:
+    return 8;
+  default:
+    return 1;
+  }
+}
+
+// Vertices of the reference cells (in Basix ordering)
+static void reference_vertex(ufcx_shape shape, int v, double x[3])
+{
+  static const double interval_v[2][3] = {{0, 0, 0}, {1, 0, 0}};
+  static const double triangle_v[3][3] = {{0, 0, 0}, {1, 0, 0}, {0, 1, 0}};
+  static const double quadrilateral_v[4][3] = {{0, 0, 0}, {1, 0, 0}, {0, 1, 0}, {1, 1, 0}};
+  static const double tetrahedron_v[4][3] = {{0, 0, 0}, {1, 0, 0}, {0, 1, 0}, {0, 0, 1}};
+  static const double prism_v[6][3]
+      = {{0, 0, 0}, {1, 0, 0}, {0, 1, 0}, {0, 0, 1}, {1, 0, 1}, {0, 1, 1}};
+  static const double pyramid_v[5][3] = {{0, 0, 0}, {1, 0, 0}, {0, 1, 0}, {1, 1, 0}, {0, 0, 1}};
+  static const double hexahedron_v[8][3]
+      = {{0, 0, 0}, {1, 0, 0}, {0, 1, 0}, {1, 1, 0}, {0, 0, 1}, {1, 0, 1}, {0, 1, 1}, {1, 1, 1}};
+  const double* r;
+  switch (shape)
+  {
+  case interval:
+    r = interval_v[v];
+    break;
+  case triangle:
+    r = triangle_v[v];
+    break;
+  case quadrilateral:
+    r = quadrilateral_v[v];
+    break;
+  case tetrahedron:
+    r = tetrahedron_v[v];
+    break;
+  case prism:
+    r = prism_v[v];
+    break;
+  case pyramid:
+    r = pyramid_v[v];
+    break;
+  case hexahedron:
+    r = hexahedron_v[v];
+    break;
+  default:
+    r = interval_v[0];
+  }
+  memcpy(x, r, 3 * sizeof(double));
+}
+
+// Random cell geometry: the vertices are mapped by a random affine map
+// close to the identity, which keeps the cell well shaped. Higher-order
+// nodes (whose reference positions are not known here) are placed near
+// the centre of the mapped cell.
+static void fill_geometry(void* x, enum real_type type, const ufcx_finite_element* element)
+{
+  const int num_nodes = element->space_dimension / element->block_size;
+  const int nv = num_vertices(element->cell_shape);
+  const int gdim = element->geometric_dimension;
+
+  double J[3][3], b[3];
+  for (int i = 0; i < 3; ++i)
+  {
+    b[i] = random_uniform();
+    for (int j = 0; j < 3; ++j)
+      J[i][j] = (i == j ? 1.0 : 0.0) + 0.2 * (random_uniform() - 0.5);
+  }
+
+  double centre[3] = {0, 0, 0};
+  for (int n = 0; n < num_nodes; ++n)
+  {
+    double r[3], p[3] = {0, 0, 0};
+    if (n < nv)
+      reference_vertex(element->cell_shape, n, r);
+    else
+    {
+      for (int i = 0; i < 3; ++i)
+        r[i] = centre[i] / nv + 0.01 * (random_uniform() - 0.5);
+    }
+    for (int i = 0; i < 3; ++i)
+    {
+      if (i < gdim)
+      {
+        p[i] = b[i];
+        for (int j = 0; j < 3; ++j)
+          p[i] += J[i][j] * r[j];
+      }
+      if (n < nv)
+        centre[i] += r[i];
+      set_real(x, type, 3 * n + i, p[i]);
+    }
+  }
+}
+
+// Time calls of a kernel, cycling through the input sets. Returns the
+// elapsed time in nanoseconds.
+#define DEFINE_RUN_KERNEL(name, scalar_t, geom_t)                                                  \
+  static double run_##name(ufcx_tabulate_tensor_##name* kernel, void* A, const void* w,          \
+                           const void* c, const void* x, const int* entity_local_index,         \
+                           const uint8_t* perm, size_t A_size, size_t w_size, size_t c_size,    \
+                           size_t x_size, long calls)                                           \
+  {                                                                                             \
+    struct timespec t0, t1;                                                                     \
+    for (int s = 0; s < NUM_SETS; ++s)                                                          \
+      kernel((scalar_t*)A + s * A_size, (const scalar_t*)w + s * w_size,                         \
+             (const scalar_t*)c + s * c_size, (const geom_t*)x + s * x_size,                     \
+             entity_local_index + 2 * s, perm + 2 * s);                                         \
+    clock_gettime(CLOCK_MONOTONIC, &t0);                                                        \
+    for (long i = 0; i < calls; ++i)                                                            \
+    {                                                                                           \
+      const int s = i % NUM_SETS;                                                               \
+      kernel((scalar_t*)A + s * A_size, (const scalar_t*)w + s * w_size,                         \
+             (const scalar_t*)c + s * c_size, (const geom_t*)x + s * x_size,                     \
+             entity_local_index + 2 * s, perm + 2 * s);                                         \
+    }                                                                                           \
+    clock_gettime(CLOCK_MONOTONIC, &t1);                                                        \
+    return (t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec);                           \
+  }
+
+DEFINE_RUN_KERNEL(float32, float, float)
+DEFINE_RUN_KERNEL(float64, double, double)
+DEFINE_RUN_KERNEL(longdouble, long double, long double)
+DEFINE_RUN_KERNEL(complex64, float _Complex, float)
+DEFINE_RUN_KERNEL(complex128, double _Complex, double)
+
+static const char* integral_type_name[] = {"cell", "exterior_facet", "interior_facet"};
+
+static void usage(const char* program)
+{
+  fprintf(stderr, "Usage: %s [-n calls] library form\n", program);
+}
+
+int main(int argc, char* argv[])
+{
+  long calls = 1000000;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "n:")) != -1)
+  {
+    switch (opt)
+    {
+    case 'n':
+    {
+      char* end;
+      calls = strtol(optarg, &end, 10);
+      if (*optarg == '\0' || *end != '\0' || calls <= 0)
+      {
+        usage(argv[0]);
+        return 1;
+      }
+      break;
+    }
+    default:
+      usage(argv[0]);
+      return 1;
+    }
+  }
+  if (optind + 2 != argc)
+  {
+    usage(argv[0]);
+    return 1;
+  }
+
+  void* library = dlopen(argv[optind], RTLD_NOW | RTLD_LOCAL);
+  if (!library)
+  {
+    fprintf(stderr, "Cannot load %s: %s\n", argv[optind], dlerror());
+    return 1;
+  }
+  const ufcx_form* form = dlsym(library, argv[optind + 1]);
+  if (!form)
+  {
+    fprintf(stderr, "Cannot find form %s: %s\n", argv[optind + 1], dlerror());
+    return 1;
+  }
+
+  printf("%-16s %6s %-12s %10s %12s %10s %10s\n", "integral", "id", "scalar", "calls", "ns/call",
+         "GFLOP/s", "GB/s");
+
+  for (int type = cell; type <= interior_facet; ++type)
+  {
+    const int restrictions = type == interior_facet ? 2 : 1;
+    const int num_integrals = form->num_integrals(type);
+    const int* ids = form->integral_ids(type);
+    ufcx_integral** integrals = form->integrals(type);
+    for (int k = 0; k < num_integrals; ++k)
+    {
+      const ufcx_integral* integral = integrals[k];
+      const ufcx_finite_element* coordinate_element = integral->coordinate_element;
+      const ufcx_shape shape = coordinate_element->cell_shape;
+
+      // Sizes of the inputs and the element tensor of one call
+      size_t A_size = 1;
+      for (int i = 0; i < integral->rank; ++i)
+        A_size *= integral->tensor_shape[i];
+      const size_t w_size = integral->num_coefficient_values;
+      const size_t c_size = integral->num_constant_values;
+      const size_t x_size = restrictions * 3 * integral->num_coordinate_dofs;
+
+      int entity_local_index[2 * NUM_SETS];
+      uint8_t perm[2 * NUM_SETS];
+      for (int s = 0; s < 2 * NUM_SETS; ++s)
+      {
+        entity_local_index[s] = (int)(random_uniform() * num_facets(shape));
+        perm[s] = (uint8_t)(random_uniform() * num_facet_permutations(shape));
+      }
+
+      for (int kind = 0; kind < 5; ++kind)
+      {
+        const char* scalar_names[] = {"float32", "float64", "longdouble", "complex64", "complex128"};
+        const enum real_type real[] = {real_float, real_double, real_longdouble, real_float, real_double};
+        const int components = kind >= 3 ? 2 : 1;
+        const bool available[] = {integral->tabulate_tensor_float32 != NULL,
+                                  integral->tabulate_tensor_float64 != NULL,
+                                  integral->tabulate_tensor_longdouble != NULL,
+                                  integral->tabulate_tensor_complex64 != NULL,
+                                  integral->tabulate_tensor_complex128 != NULL};
+        if (!available[kind])
+          continue;
+
+        const size_t rsize = real_size[real[kind]];
+        void* A = calloc(NUM_SETS * A_size * components, rsize);
+        void* w = malloc((NUM_SETS * w_size * components + 1) * rsize);
+        void* c = malloc((NUM_SETS * c_size * components + 1) * rsize);
+        void* x = malloc(NUM_SETS * x_size * rsize);
+        fill_random(w, real[kind], NUM_SETS * w_size * components);
+        fill_random(c, real[kind], NUM_SETS * c_size * components);
+        for (int s = 0; s < NUM_SETS; ++s)
+        {
+          for (int r = 0; r < restrictions; ++r)
+          {
+            fill_geometry((char*)x + (s * x_size + r * x_size / restrictions) * rsize, real[kind],
+                          coordinate_element);
+          }
+        }
+
+        double ns = 0;
+        switch (kind)
+        {
+        case 0:
+          ns = run_float32(integral->tabulate_tensor_float32, A, w, c, x, entity_local_index, perm,
+                           A_size, w_size, c_size, x_size, calls);
+          break;
+        case 1:
+          ns = run_float64(integral->tabulate_tensor_float64, A, w, c, x, entity_local_index, perm,
+                           A_size, w_size, c_size, x_size, calls);
+          break;
+        case 2:
+          ns = run_longdouble(integral->tabulate_tensor_longdouble, A, w, c, x, entity_local_index,
+                              perm, A_size, w_size, c_size, x_size, calls);
+          break;
+        case 3:
+          ns = run_complex64(integral->tabulate_tensor_complex64, A, w, c, x, entity_local_index, perm,
+                             A_size, w_size, c_size, x_size, calls);
+          break;
+        case 4:
+          ns = run_complex128(integral->tabulate_tensor_complex128, A, w, c, x, entity_local_index,
+                              perm, A_size, w_size, c_size, x_size, calls);
+          break;
+        }
+
+        const double ns_per_call = ns / calls;
+        const double bytes
+            = (2.0 * A_size + w_size + c_size) * components * rsize + x_size * rsize;
+        printf("%-16s %6d %-12s %10ld %12.2f ", integral_type_name[type], ids[k], scalar_names[kind],
+               calls, ns_per_call);
+        if (integral->flops >= 0)
+          printf("%10.3f ", integral->flops / ns_per_call);
+        else
+          printf("%10s ", "-");
+        printf("%10.3f\n", bytes / ns_per_call);
+
+        free(A);
+        free(w);
+        free(c);
+        free(x);
+      }
+    }
+  }
+
+  dlclose(library);
+  return 0;
+}
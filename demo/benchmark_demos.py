@@ -0,0 +1,222 @@
+# Copyright (C) 2022 FEniCS Project
+#
+# This file is part of FFCx. (https://www.fenicsproject.org)
+#
+# SPDX-License-Identifier:    LGPL-3.0-or-later
+"""Performance regression suite over the demo forms.
+
+Record, for each demo and option set, the time of each compiler stage
+and of the steps of the intermediate representation (e.g.
+factorisation), the size of the generated code, the flops of each kernel
+and (with the ufcx_benchmark driver built from cmake/) the measured
+kernel runtime::
+
+    python3 benchmark_demos.py run -o baseline.json
+    ... change the code generator ...
+    python3 benchmark_demos.py run -o new.json
+    python3 benchmark_demos.py compare baseline.json new.json
+
+``compare`` lists the metrics that got worse by more than a threshold
+and exits with status 1 if there are any. To time a change to a single
+demo, e.g. of the factorisation of the HyperElasticity Jacobian, run
+``python3 benchmark_demos.py run HyperElasticity.py --no-runtime -o
+before.json`` before and after the change and compare the ``ir_seconds``.
+"""
+
+import argparse
+import json
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+
+import ufl
+from ffcx import __version__ as FFCX_VERSION
+from ffcx import compiler, naming, profiling
+from ffcx.analysis import analyze_ufl_objects, clear_form_data_cache
+from ffcx.codegeneration import get_include_path
+from ffcx.codegeneration.backend import FFCXBackend
+from ffcx.codegeneration.integrals import IntegralGenerator
+from ffcx.ir.representation import compute_ir
+from ffcx.main import file_prefix
+from ffcx.options import get_options
+
+demo_dir = os.path.dirname(os.path.realpath(__file__))
+
+# Option sets to benchmark every demo with, by name
+default_option_sets = {"double": {}, "float": {"scalar_type": "float"}}
+
+# Metrics that depend on timing, and are compared with a separate
+# threshold
+timing_metrics = ("stage_seconds", "ir_seconds", "runtime_ns")
+
+
+def demo_files():
+    """Return the UFL files of the demos."""
+    return sorted(os.path.join(demo_dir, f) for f in os.listdir(demo_dir)
+                  if f.endswith(".py") and not f.startswith(("test_", "benchmark_")))
+
+
+def integral_key(form_index, integral_type, subdomain_id):
+    """Return the key of an integral in the flops and runtime results."""
+    subdomain_id = -1 if subdomain_id == "otherwise" else subdomain_id
+    return f"{form_index}/{integral_type}/{subdomain_id}"
+
+
+def ir_seconds(events):
+    """Sum the time of each step of the intermediate representation over all integrals."""
+    seconds = {}
+    for e in events:
+        if e["cat"] == "ir":
+            seconds[e["name"]] = seconds.get(e["name"], 0.0) + e["dur"] * 1e-6
+    return seconds
+
+
+def kernel_flops(forms, options):
+    """Count the flops of each kernel of each form."""
+    flops = {}
+    for i, form in enumerate(forms):
+        analysis = analyze_ufl_objects([form], options)
+        ir = compute_ir(analysis, {}, "flops", options, False)
+        for integral_ir in ir.integrals:
+            backend = FFCXBackend(integral_ir, options)
+            ast = IntegralGenerator(integral_ir, backend).generate()
+            flops[integral_key(i, integral_ir.integral_type, integral_ir.subdomain_id)] = ast.flops()
+    return flops
+
+
+def kernel_runtimes(code_c, form_names, driver, calls, cflags):
+    """Measure the runtime of each kernel with the ufcx_benchmark driver."""
+    runtimes = {}
+    with tempfile.TemporaryDirectory() as tmpdir:
+        c_file = os.path.join(tmpdir, "forms.c")
+        library = os.path.join(tmpdir, "libforms.so")
+        with open(c_file, "w") as f:
+            f.write(code_c)
+        subprocess.run([os.environ.get("CC", "cc"), "-shared", "-fPIC", f"-I{get_include_path()}"]
+                       + cflags + [c_file, "-o", library], check=True)
+        for i, name in enumerate(form_names):
+            output = subprocess.run([driver, "-n", str(calls), library, name], check=True,
+                                    stdout=subprocess.PIPE, text=True).stdout
+            for line in output.splitlines()[1:]:
+                integral_type, subdomain_id, scalar, _, ns_per_call = line.split()[:5]
+                runtimes[f"{integral_key(i, integral_type, int(subdomain_id))}/{scalar}"] = float(ns_per_call)
+    return runtimes
+
+
+def benchmark_demo(filename, options, driver, calls, cflags):
+    """Compile a demo and return its metrics."""
+    prefix = file_prefix(filename)
+    ufd = ufl.algorithms.load_ufl_file(filename)
+
+    # Time the analysis of each option set, not a cached one
+    clear_form_data_cache()
+    profiling.enable()
+    code_h, code_c = compiler.compile_ufl_objects(ufd.forms + ufd.expressions + ufd.elements,
+                                                  ufd.object_names, prefix=prefix, options=options)
+    events = profiling.disable()
+
+    result = {
+        "stage_seconds": {e["name"]: e["dur"] * 1e-6 for e in events if e["cat"] == "stage"},
+        "ir_seconds": ir_seconds(events),
+        "code_bytes": {"h": len(code_h), "c": len(code_c)},
+        "flops": kernel_flops(ufd.forms, options),
+    }
+    if driver is not None:
+        form_names = [naming.form_name(form, i, prefix) for i, form in enumerate(ufd.forms)]
+        result["runtime_ns"] = kernel_runtimes(code_c, form_names, driver, calls, cflags)
+
+    return result
+
+
+def run(args):
+    option_sets = default_option_sets.copy()
+    for option_set in args.option_set:
+        name, _, value = option_set.partition("=")
+        option_sets[name] = json.loads(value)
+    driver = None if args.no_runtime else args.driver or shutil.which("ufcx_benchmark")
+    if driver is None and not args.no_runtime:
+        print("ufcx_benchmark not found, kernel runtimes are not measured.", file=sys.stderr)
+
+    results = {}
+    for filename in args.demos or demo_files():
+        demo = os.path.splitext(os.path.basename(filename))[0]
+        for name, priority_options in option_sets.items():
+            print(f"Benchmarking {demo} ({name})", file=sys.stderr)
+            try:
+                results[f"{demo}/{name}"] = benchmark_demo(filename, get_options(priority_options), driver,
+                                                           args.calls, args.cflags.split())
+            except Exception as e:
+                print(f"Failed to benchmark {demo} ({name}): {e!r}", file=sys.stderr)
+
+    with open(args.output, "w") as f:
+        json.dump({"ffcx_version": FFCX_VERSION, "option_sets": option_sets, "results": results}, f, indent=2)
+
+    return 0
+
+
+def compare_results(baseline, results, threshold, time_threshold):
+    """Return a list of regressions of the results with respect to the baseline.
+
+    All metrics are "lower is better". Timings regress if they grow by
+    more than time_threshold (relative), everything else if it grows by
+    more than threshold.
+    """
+    regressions = []
+    for case, metrics in sorted(results.items()):
+        if case not in baseline:
+            continue
+        for metric, values in metrics.items():
+            limit = time_threshold if metric in timing_metrics else threshold
+            for key, value in values.items():
+                old = baseline[case].get(metric, {}).get(key)
+                if old is not None and value > old * (1 + limit):
+                    regressions.append((case, metric, key, old, value))
+    return regressions
+
+
+def compare(args):
+    with open(args.baseline) as f:
+        baseline = json.load(f)["results"]
+    with open(args.results) as f:
+        results = json.load(f)["results"]
+
+    regressions = compare_results(baseline, results, args.threshold, args.time_threshold)
+    for case, metric, key, old, new in regressions:
+        change = f" ({100 * (new / old - 1):+.1f}%)" if old else ""
+        print(f"{case}: {metric} {key}: {old:g} -> {new:g}{change}")
+    missing = sorted(set(baseline) - set(results))
+    for case in missing:
+        print(f"{case}: missing from results")
+
+    return 1 if regressions or missing else 0
+
+
+parser = argparse.ArgumentParser(description="Performance regression suite over the FFCx demo forms")
+subparsers = parser.add_subparsers(dest="command", required=True)
+
+run_parser = subparsers.add_parser("run", help="benchmark the demos")
+run_parser.add_argument("demos", nargs="*", help="UFL files to benchmark (default: all demos)")
+run_parser.add_argument("-o", "--output", required=True, help="JSON file to write the results to")
+run_parser.add_argument("--option-set", action="append", default=[], metavar="NAME=JSON",
+                        help="additional set of FFCx options to benchmark with")
+run_parser.add_argument("--driver", help="path to the ufcx_benchmark driver")
+run_parser.add_argument("--no-runtime", action="store_true", help="do not measure kernel runtimes")
+run_parser.add_argument("--calls", type=int, default=100000, help="number of calls of each kernel")
+run_parser.add_argument("--cflags", default="-O2", help="flags to compile the generated code with")
+run_parser.set_defaults(function=run)
+
+compare_parser = subparsers.add_parser("compare", help="compare results with a baseline")
+compare_parser.add_argument("baseline", help="JSON file with the baseline results")
+compare_parser.add_argument("results", help="JSON file with the new results")
+compare_parser.add_argument("--threshold", type=float, default=0.01,
+                            help="relative increase of code size or flops that counts as a regression")
+compare_parser.add_argument("--time-threshold", type=float, default=0.2,
+                            help="relative increase of compile time or runtime that counts as a regression")
+compare_parser.set_defaults(function=compare)
+
+
+if __name__ == "__main__":
+    args = parser.parse_args()
+    sys.exit(args.function(args))
@@ -1,3 +1,4 @@
+import json
 import os
 import sys
 
@@ -7,7 +8,7 @@ demo_dir = os.path.dirname(os.path.realpath(__file__))
 
 ufl_files = []
 for file in os.listdir(demo_dir):
-    if file.endswith(".py") and not file == "test_demos.py":
+    if file.endswith(".py") and not file.startswith(("test_", "benchmark_")):
         ufl_files.append(file[:-3])
 
 
@@ -28,3 +29,24 @@ def test_demo(file):
                      "CPATH=../ffcx/codegeneration/ "
                      f"gcc -I/usr/include/python{sys.version_info.major}.{sys.version_info.minor} {extra_flags}"
                      f"-shared {file}.c -o {file}.so") == 0
+
+
+def test_benchmark_demos(tmp_path):
+    sys.path.insert(0, demo_dir)
+    import benchmark_demos
+
+    results = str(tmp_path / "results.json")
+    args = benchmark_demos.parser.parse_args(["run", "-o", results, "--no-runtime",
+                                              os.path.join(demo_dir, "Poisson1D.py")])
+    assert benchmark_demos.run(args) == 0
+    with open(results) as f:
+        data = json.load(f)["results"]
+    assert set(data) == {"Poisson1D/double", "Poisson1D/float"}
+    assert data["Poisson1D/double"]["code_bytes"]["c"] > 0
+    assert all(flops > 0 for flops in data["Poisson1D/double"]["flops"].values())
+    assert benchmark_demos.compare(benchmark_demos.parser.parse_args(["compare", results, results])) == 0
+
+    # Regressions beyond the threshold are flagged
+    baseline = {"Poisson1D/double": {"flops": {"0/cell/-1": 100}, "runtime_ns": {"0/cell/-1/float64": 10.0}}}
+    new = {"Poisson1D/double": {"flops": {"0/cell/-1": 102}, "runtime_ns": {"0/cell/-1/float64": 11.0}}}
+    assert len(benchmark_demos.compare_results(baseline, new, 0.01, 0.2)) == 1
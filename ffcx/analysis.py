@@ -11,6 +11,8 @@ including automatic selection of elements, degrees and form
 representation type.
 """
 
+import collections
+import copy
 import logging
 import typing
 
@@ -19,11 +21,18 @@ import numpy.typing
 
 import basix.ufl_wrapper
 import ufl
+from ffcx import profiling
 from ffcx.element_interface import convert_element, QuadratureElement
 from warnings import warn
 
 logger = logging.getLogger("ffcx")
 
+# Analysed forms, keyed by form signature and complex mode, in least
+# recently used order. Entries keep the forms and their coefficients
+# alive, so the cache is small.
+_form_data_cache: typing.Dict[typing.Tuple[str, bool], ufl.algorithms.formdata.FormData] = collections.OrderedDict()
+FORM_DATA_CACHE_SIZE = 16
+
 
 class UFLData(typing.NamedTuple):
     form_data: typing.Tuple[ufl.algorithms.formdata.FormData, ...]  # Tuple of ufl form data
@@ -127,6 +136,20 @@ def _analyze_expression(expression: ufl.core.expr.Expr, options: typing.Dict):
     return expression
 
 
+def clear_form_data_cache():
+    """Clear the cache of analysed forms."""
+    _form_data_cache.clear()
+
+
+def _same_form_arguments(form0: ufl.form.Form, form1: ufl.form.Form) -> bool:
+    """Check if two forms have the same coefficient, argument and constant objects."""
+    for f0, f1 in ((form0.coefficients(), form1.coefficients()), (form0.arguments(), form1.arguments()),
+                   (form0.constants(), form1.constants())):
+        if len(f0) != len(f1) or any(a is not b for a, b in zip(f0, f1)):
+            return False
+    return True
+
+
 def _analyze_form(form: ufl.form.Form, options: typing.Dict) -> ufl.algorithms.formdata.FormData:
     """Analyzes UFL form and attaches metadata.
 
@@ -145,6 +168,10 @@ def _analyze_form(form: ufl.form.Form, options: typing.Dict) -> ufl.algorithms.f
     from options, integral metadata or inherited from UFL
     (in case of quadrature degree)
 
+    The form data is cached by form signature and complex mode, and
+    reused for forms with the same coefficient, argument and constant
+    objects.
+
     """
     if form.empty():
         raise RuntimeError(f"Form ({form}) seems to be zero: cannot compile it.")
@@ -160,6 +187,29 @@ def _analyze_form(form: ufl.form.Form, options: typing.Dict) -> ufl.algorithms.f
     # Check for complex mode
     complex_mode = "_Complex" in options["scalar_type"]
 
+    key = (form.signature(), complex_mode)
+    cached = _form_data_cache.get(key)
+    if cached is not None and _same_form_arguments(cached.original_form, form):
+        logger.info(f"Reusing analysis of form with signature {key[0]}")
+        _form_data_cache.move_to_end(key)
+        if cached.original_form is form:
+            return cached
+        form_data = copy.copy(cached)
+        form_data.original_form = form
+        return form_data
+
+    with profiling.region("compute_form_data", "analysis", signature=key[0]) as counts:
+        form_data = _compute_form_data(form, complex_mode)
+        counts["num_integrals"] = sum(len(itg_data.integrals) for itg_data in form_data.integral_data)
+    _form_data_cache[key] = form_data
+    while len(_form_data_cache) > FORM_DATA_CACHE_SIZE:
+        _form_data_cache.popitem(last=False)
+
+    return form_data
+
+
+def _compute_form_data(form: ufl.form.Form, complex_mode: bool) -> ufl.algorithms.formdata.FormData:
+    """Compute UFL form data and attach quadrature metadata."""
     # Compute form metadata
     form_data = ufl.algorithms.compute_form_data(
         form,
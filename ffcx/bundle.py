@@ -0,0 +1,99 @@
+# Copyright (C) 2022 FEniCS Project
+#
+# This file is part of FFCx.(https://www.fenicsproject.org)
+#
+# SPDX-License-Identifier:    LGPL-3.0-or-later
+"""Command-line interface to compile UFL files into a bundle of forms.
+
+A bundle is a single shared library containing the generated code of
+all forms in the given UFL files, together with an exported index from
+form signature to ``ufcx_form*``. Registered bundles (see
+``ffcx.codegeneration.jit.register_bundle`` and the ``FFCX_BUNDLES``
+environment variable) are consulted by
+``ffcx.codegeneration.jit.compile_forms`` before JIT compiling, so that
+no compiler is needed at runtime.
+"""
+
+import argparse
+import logging
+import shlex
+import tempfile
+from pathlib import Path
+
+import ufl
+from ffcx import __version__ as FFCX_VERSION
+from ffcx import compiler, naming
+from ffcx.codegeneration import jit
+from ffcx.main import add_option_arguments, file_prefix
+from ffcx.options import FFCX_DEFAULT_OPTIONS, get_options
+
+logger = logging.getLogger("ffcx")
+
+parser = argparse.ArgumentParser(
+    description="Compile UFL files into a bundle of forms (FFCx, https://fenicsproject.org)")
+parser.add_argument(
+    "--version", action='version', version=f"%(prog)s (version {FFCX_VERSION})")
+parser.add_argument("-o", "--output", type=str, default="libffcx_bundle.so", help="output shared library")
+parser.add_argument("--cflags", type=str, default="", help="additional C compiler flags")
+parser.add_argument("--sources", type=str, help="directory to keep the generated C files in")
+
+add_option_arguments(parser)
+parser.add_argument("ufl_file", nargs='+', help="UFL file(s) to be compiled")
+
+
+def generate_index(entries):
+    """Generate C code of the bundle index for (signature, form name) pairs."""
+    code = "#include <ufcx.h>\n"
+    code += jit.BUNDLE_DECL
+    code += "\n"
+    for _, name in entries:
+        code += f"extern ufcx_form {name};\n"
+    code += "\nffcx_bundle_entry ffcx_bundle_forms[] = {\n"
+    code += "".join(f'  {{"{signature}", &{name}}},\n' for signature, name in entries)
+    if not entries:
+        code += "  {0, 0}\n"
+    code += "};\n\n"
+    code += f"int ffcx_bundle_num_forms = {len(entries)};\n"
+    return code
+
+
+def main(args=None):
+    xargs = parser.parse_args(args)
+
+    priority_options = {k: v for k, v in xargs.__dict__.items() if v is not None and k in FFCX_DEFAULT_OPTIONS}
+    options = get_options(priority_options)
+
+    source_dir = Path(xargs.sources if xargs.sources is not None else tempfile.mkdtemp())
+    source_dir.mkdir(parents=True, exist_ok=True)
+
+    sources = []
+    entries = {}
+    for filename in xargs.ufl_file:
+        prefix = file_prefix(filename)
+        ufd = ufl.algorithms.load_ufl_file(filename)
+
+        compiler.write_ufl_objects(ufd.forms + ufd.expressions + ufd.elements, str(source_dir),
+                                   ufd.object_names, prefix=prefix, options=options)
+        sources.append(source_dir.joinpath(prefix + ".c"))
+
+        for i, form in enumerate(ufd.forms):
+            signature = jit.bundle_signature(form, options)
+            if signature in entries:
+                logger.info(f"Form {i} of {filename} is already in the bundle.")
+            else:
+                entries[signature] = naming.form_name(form, i, prefix)
+
+    index_filename = source_dir.joinpath("ffcx_bundle_index.c")
+    with open(index_filename, "w") as f:
+        f.write(generate_index(list(entries.items())))
+    sources.append(index_filename)
+
+    output = jit._link_shared_library(sources, Path(xargs.output).resolve(), shlex.split(xargs.cflags), False, None)
+    logger.info(output)
+
+    return 0
+
+
+if __name__ == "__main__":
+    import sys
+    sys.exit(main())
@@ -4,6 +4,7 @@
 #
 # SPDX-License-Identifier:    LGPL-3.0-or-later
 
+import collections
 import logging
 import numbers
 
@@ -77,6 +78,44 @@ class CNode(object):
     def __ne__(self, other):
         return not self.__eq__(other)
 
+    def children(self):
+        """Return the CNodes directly contained in this node."""
+        children = []
+        for cls in type(self).__mro__:
+            for name in getattr(cls, "__slots__", ()):
+                children += _cnodes_in(getattr(self, name, None))
+        return children
+
+    def memory_accesses(self):
+        """Count the array element accesses of one execution of this node.
+
+        Returns a Counter mapping (array name, "load" or "store") to the
+        number of accesses. Every access is counted, i.e. reuse of values
+        in registers is not taken into account, and both branches of
+        conditionals are counted.
+        """
+        accesses = collections.Counter()
+        for child in self.children():
+            accesses.update(child.memory_accesses())
+        return accesses
+
+
+def _cnodes_in(value):
+    """Return the CNodes in a slot value, which may be a (nested) list or tuple."""
+    if isinstance(value, CNode):
+        return [value]
+    elif isinstance(value, (list, tuple)):
+        return [node for v in value for node in _cnodes_in(v)]
+    else:
+        return []
+
+
+def iter_nodes(node):
+    """Iterate over a CNode and all nodes contained in it, depth first."""
+    yield node
+    for child in node.children():
+        yield from iter_nodes(child)
+
 # CExpr base classes
 
 
@@ -688,6 +727,19 @@ class AssignOp(BinOp):
     def __init__(self, lhs, rhs):
         BinOp.__init__(self, as_cexpr_or_string_symbol(lhs), rhs)
 
+    def memory_accesses(self):
+        accesses = self.rhs.memory_accesses()
+        if isinstance(self.lhs, ArrayAccess):
+            name = _array_name(self.lhs.array)
+            accesses[(name, "store")] += 1
+            if self.op != "=":
+                accesses[(name, "load")] += 1
+            for index in self.lhs.indices:
+                accesses.update(index.memory_accesses())
+        else:
+            accesses.update(self.lhs.memory_accesses())
+        return accesses
+
 
 class Assign(AssignOp):
     __slots__ = ()
@@ -840,6 +892,26 @@ class ArrayAccess(CExprOperator):
     def flops(self):
         return 0
 
+    def memory_accesses(self):
+        accesses = collections.Counter({(_array_name(self.array), "load"): 1})
+        for index in self.indices:
+            accesses.update(index.memory_accesses())
+        return accesses
+
+
+def _array_name(array):
+    """Return the name under which accesses to an array are counted.
+
+    Arrays that are not a plain symbol, e.g. pointer expressions, are
+    counted under their C code.
+    """
+    if isinstance(array, Symbol):
+        return array.name
+    elif isinstance(array, CNode):
+        return array.ce_format()
+    else:
+        return str(array)
+
 
 class Conditional(CExprOperator):
     __slots__ = ("condition", "true", "false")
@@ -872,7 +944,8 @@ class Conditional(CExprOperator):
                 and self.true == other.true and self.false == other.false)
 
     def flops(self):
-        raise NotImplementedError("Flop count is not implemented for conditionals")
+        # Count the more expensive branch
+        return self.condition.flops() + max(self.true.flops(), self.false.flops())
 
 
 class Call(CExprOperator):
@@ -1038,6 +1111,10 @@ class VerbatimStatement(CStatement):
     def __eq__(self, other):
         return (isinstance(other, type(self)) and self.codestring == other.codestring)
 
+    def flops(self):
+        # The code is opaque, assume it does no floating point work
+        return 0
+
 
 class Statement(CStatement):
     """Make an expression into a statement."""
@@ -1419,6 +1496,12 @@ class ArrayDecl(CStatement):
     def flops(self):
         return 0
 
+    def memory_accesses(self):
+        # Static arrays are initialized once, not per call
+        if self.values is None or "static" in self.typename.split():
+            return collections.Counter()
+        return collections.Counter({(self.symbol.name, "store"): int(numpy.prod(self.sizes))})
+
 
 # Scoped statements
 
@@ -1609,6 +1692,10 @@ class ForRange(CStatement):
     def flops(self):
         return (self.end.value - self.begin.value) * self.body.flops()
 
+    def memory_accesses(self):
+        n = self.end.value - self.begin.value
+        return collections.Counter({key: n * count for key, count in self.body.memory_accesses().items()})
+
 
 # Conversion function to statement nodes
 
@@ -14,6 +14,7 @@ UFC function from an intermediate representation (IR).
 import logging
 import typing
 
+from ffcx import profiling
 from ffcx.codegeneration.dofmap import generator as dofmap_generator
 from ffcx.codegeneration.expressions import generator as expression_generator
 from ffcx.codegeneration.finite_element import \
@@ -45,10 +46,39 @@ def generate_code(ir, options) -> CodeBlocks:
     logger.info(79 * "*")
 
     # Generate code for finite_elements
-    code_finite_elements = [finite_element_generator(element_ir, options) for element_ir in ir.elements]
-    code_dofmaps = [dofmap_generator(dofmap_ir, options) for dofmap_ir in ir.dofmaps]
-    code_integrals = [integral_generator(integral_ir, options) for integral_ir in ir.integrals]
-    code_forms = [form_generator(form_ir, options) for form_ir in ir.forms]
-    code_expressions = [expression_generator(expression_ir, options) for expression_ir in ir.expressions]
+    code_finite_elements = [_generate(finite_element_generator, element_ir, options) for element_ir in ir.elements]
+    code_dofmaps = [_generate(dofmap_generator, dofmap_ir, options) for dofmap_ir in ir.dofmaps]
+    code_integrals = [_generate(integral_generator, integral_ir, options) for integral_ir in ir.integrals]
+    code_forms = [_generate(form_generator, form_ir, options) for form_ir in ir.forms]
+    code_expressions = [_generate(expression_generator, expression_ir, options) for expression_ir in ir.expressions]
     return CodeBlocks(elements=code_finite_elements, dofmaps=code_dofmaps,
                       integrals=code_integrals, forms=code_forms, expressions=code_expressions)
+
+
+def generate_code_blocks(ir, options, manifest=None) -> typing.Iterator[typing.Tuple[str, str]]:
+    """Generate code blocks one at a time from intermediate representation.
+
+    The blocks are produced in the same order as the fields of
+    CodeBlocks. The lists of the IR are consumed, so that each IR entry
+    can be released as soon as its code has been generated. If a
+    manifest (see ffcx.codegeneration.manifest) is given, the kernels of
+    the integrals and expressions are added to it as they are generated.
+
+    """
+    logger.info(79 * "*")
+    logger.info("Compiler stage 3: Generating code")
+    logger.info(79 * "*")
+
+    for irs, generator in ((ir.elements, finite_element_generator), (ir.dofmaps, dofmap_generator),
+                           (ir.integrals, integral_generator), (ir.forms, form_generator),
+                           (ir.expressions, expression_generator)):
+        kwargs = {"manifest": manifest} if manifest is not None and generator in (
+            integral_generator, expression_generator) else {}
+        irs.reverse()
+        while irs:
+            yield _generate(generator, irs.pop(), options, **kwargs)
+
+
+def _generate(generator, ir, options, **kwargs):
+    with profiling.region(ir.name, "code generation"):
+        return generator(ir, options, **kwargs)
@@ -20,8 +20,8 @@ from ffcx.naming import cdtype_to_numpy, scalar_to_value_type
 logger = logging.getLogger("ffcx")
 
 
-def generator(ir, options):
-    """Generate UFC code for an expression."""
+def generator(ir, options, manifest=None):
+    """Generate UFC code for an expression, adding its kernel to the manifest if given."""
     logger.info("Generating code for expression:")
     logger.info(f"--- points: {ir.points}")
     logger.info(f"--- name: {ir.name}")
@@ -41,6 +41,8 @@ def generator(ir, options):
     d["factory_name"] = ir.name
 
     parts = eg.generate()
+    if manifest is not None:
+        manifest.add_expression(ir, parts)
 
     body = format_indented_lines(parts.cs_format(), 1)
     d["tabulate_expression"] = body
@@ -182,12 +184,10 @@ class ExpressionGenerator:
         cells: Dict[Any, Set[Any]] = {t: set() for t in ufl_geometry.keys()}
 
         for integrand in self.ir.integrand.values():
-            for attr in integrand["factorization"].nodes.values():
-                mt = attr.get("mt")
-                if mt is not None:
-                    t = type(mt.terminal)
-                    if t in ufl_geometry:
-                        cells[t].add(mt.terminal.ufl_domain().ufl_cell().cellname())
+            for mt in integrand["factorization"].mt.values():
+                t = type(mt.terminal)
+                if t in ufl_geometry:
+                    cells[t].add(mt.terminal.ufl_domain().ufl_cell().cellname())
 
         parts = []
         for i, cell_list in cells.items():
@@ -346,7 +346,7 @@ class ExpressionGenerator:
                 B_indices = tuple([iq] + list(B_indices))
                 A_indices = tuple([iq] + A_indices)
                 for fi_ci in blockdata.factor_indices_comp_indices:
-                    f = self.get_var(F.nodes[fi_ci[0]]["expression"])
+                    f = self.get_var(F.expressions[fi_ci[0]])
                     arg_factors = self.get_arg_factors(blockdata, block_rank, B_indices)
                     Brhs = L.float_product([f] + arg_factors)
                     quadparts.append(L.AssignAdd(A[(A_indices[0], fi_ci[1]) + A_indices[1:]], Brhs))
@@ -379,7 +379,7 @@ class ExpressionGenerator:
             body = []
 
             for fi_ci in blockdata.factor_indices_comp_indices:
-                f = self.get_var(F.nodes[fi_ci[0]]["expression"])
+                f = self.get_var(F.expressions[fi_ci[0]])
                 Brhs = L.float_product([f] + arg_factors)
                 body.append(L.AssignAdd(A[(A_indices[0], fi_ci[1]) + A_indices[1:]], Brhs))
 
@@ -443,18 +443,16 @@ class ExpressionGenerator:
 
         use_symbol_array = True
 
-        for i, attr in F.nodes.items():
-            if attr['status'] != mode:
-                continue
-            v = attr['expression']
-            mt = attr.get('mt')
+        for i in F.nodes_with_status(mode):
+            v = F.expressions[i]
+            mt = F.mt.get(i)
 
             if v._ufl_is_literal_:
                 vaccess = self.backend.ufl_to_language.get(v)
             elif mt is not None:
                 # All finite element based terminals have table data, as well
                 # as some, but not all, of the symbolic geometric terminals
-                tabledata = attr.get('tr')
+                tabledata = F.tr.get(i)
 
                 # Backend specific modified terminal translation
                 vaccess = self.backend.access.get(mt.terminal, mt, tabledata, 0)
@@ -471,9 +469,10 @@ class ExpressionGenerator:
                 vops = [self.get_var(op) for op in v.ufl_operands]
 
                 # get parent operand
-                pid = F.in_edges[i][0] if F.in_edges[i] else -1
+                parents = F.in_edges(i)
+                pid = parents[0] if parents else -1
                 if pid and pid > i:
-                    parent_exp = F.nodes.get(pid)['expression']
+                    parent_exp = F.expressions[pid]
                 else:
                     parent_exp = None
 
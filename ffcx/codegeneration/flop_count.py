@@ -5,30 +5,94 @@
 
 from typing import Optional
 
+import ffcx.codegeneration.C.cnodes as L
 import ffcx.options
 import ufl
 from ffcx.analysis import analyze_ufl_objects
 from ffcx.codegeneration.backend import FFCXBackend
 from ffcx.codegeneration.integrals import IntegralGenerator
 from ffcx.ir.representation import compute_ir
+from ffcx.naming import c_type_size, scalar_to_value_type
 
 
-def count_flops(form: ufl.Form, options: Optional[dict] = {}):
-    """Return a list with the number of flops for each kernel in the Form."""
-    options = ffcx.options.get_options(options)
+def _kernel_asts(form: ufl.Form, options: dict):
+    """Generate the tabulate_tensor body ast of each kernel in the Form."""
     assert isinstance(form, ufl.Form)
     analysis = analyze_ufl_objects([form], options)
     ir = compute_ir(analysis, {}, "flops", options, False)
 
-    flops = []
-
     for integral_ir in ir.integrals:
         # Create FFCx C backend
         backend = FFCXBackend(integral_ir, options)
         # Configure kernel generator
         ig = IntegralGenerator(integral_ir, backend)
         # Generate code ast for the tabulate_tensor body
-        ast = ig.generate()
-        flops.append(ast.flops())
+        yield integral_ir, ig.generate()
+
+
+def count_flops(form: ufl.Form, options: Optional[dict] = {}):
+    """Return a list with the number of flops for each kernel in the Form."""
+    options = ffcx.options.get_options(options)
+    return [ast.flops() for _, ast in _kernel_asts(form, options)]
+
+
+def count_memory_traffic(ast: L.CNode, options: dict):
+    """Estimate the bytes loaded and stored by one call of a kernel.
+
+    The traffic is split into static tables, the kernel arguments (the
+    element tensor and the input arrays) and scratch arrays declared in
+    the kernel. Every array access in the ast is counted, so this is an
+    upper bound that ignores reuse of values in registers.
+    """
+    scalar_type = options["scalar_type"]
+    argument_types = {"A": scalar_type, "w": scalar_type, "c": scalar_type,
+                      "coordinate_dofs": scalar_to_value_type(scalar_type),
+                      "entity_local_index": "int", "quadrature_permutation": "uint8_t"}
+
+    # Arrays declared in the kernel are tables if static, otherwise scratch
+    declarations = {node.symbol.name: node for node in L.iter_nodes(ast) if isinstance(node, L.ArrayDecl)}
+
+    traffic = {"tables": {"load": 0, "store": 0}, "arguments": {"load": 0, "store": 0},
+               "scratch": {"load": 0, "store": 0}}
+    for (name, kind), count in ast.memory_accesses().items():
+        if name in declarations:
+            typename = declarations[name].typename
+            category = "tables" if "static" in typename.split() else "scratch"
+        else:
+            typename = argument_types.get(name, scalar_type)
+            category = "arguments"
+        traffic[category][kind] += count * c_type_size(typename)
+
+    return traffic
+
+
+def kernel_statistics(form: ufl.Form, options: Optional[dict] = {}, machine_balance: float = 8.0):
+    """Return the flops, memory traffic and arithmetic intensity of each kernel in the Form.
+
+    The arithmetic intensity is the number of flops per byte of memory
+    traffic (see ``count_memory_traffic``). A kernel is classified as
+    "memory" bound in the roofline model if its intensity is below the
+    machine balance, i.e. the peak flops per byte of memory bandwidth of
+    the target machine, and as "compute" bound otherwise.
+
+    Returns a list with a dictionary for each kernel.
+    """
+    options = ffcx.options.get_options(options)
+
+    statistics = []
+    for integral_ir, ast in _kernel_asts(form, options):
+        flops = ast.flops()
+        traffic = count_memory_traffic(ast, options)
+        total_bytes = sum(c["load"] + c["store"] for c in traffic.values())
+        intensity = flops / total_bytes if total_bytes > 0 else float("inf")
+        statistics.append({
+            "integral_type": integral_ir.integral_type,
+            "subdomain_id": integral_ir.subdomain_id,
+            "flops": flops,
+            "bytes": traffic,
+            "total_bytes": total_bytes,
+            "arithmetic_intensity": intensity,
+            "bound": "memory" if intensity < machine_balance else "compute",
+        })
 
-    return flops
+    return statistics
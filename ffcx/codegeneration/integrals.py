@@ -6,23 +6,31 @@
 
 import collections
 import logging
+import re
 from typing import Any, Dict, List, Set, Tuple
 
+import numpy
+
 import ufl
+from ffcx import profiling
 from ffcx.codegeneration import geometry
 from ffcx.codegeneration import integrals_template as ufcx_integrals
 from ffcx.codegeneration.backend import FFCXBackend
-from ffcx.codegeneration.C.cnodes import BinOp, CNode
+from ffcx.codegeneration.C.cnodes import (ArrayDecl, BinOp, CNode, iter_nodes,
+                                          pad_innermost_dim)
 from ffcx.codegeneration.C.format_lines import format_indented_lines
 from ffcx.ir.elementtables import piecewise_ttypes
 from ffcx.ir.integral import BlockDataT
 from ffcx.ir.representationutils import QuadratureRule
-from ffcx.naming import cdtype_to_numpy, scalar_to_value_type
+from ffcx.naming import c_type_size, cdtype_to_numpy, scalar_to_value_type
 
 logger = logging.getLogger("ffcx")
 
+# Number of independent partial sums of the batched functional kernels
+FUNCTIONAL_PARTIAL_SUMS = 4
+
 
-def generator(ir, options):
+def generator(ir, options, manifest=None):
     logger.info("Generating code for integral:")
     logger.info(f"--- type: {ir.integral_type}")
     logger.info(f"--- name: {ir.name}")
@@ -40,10 +48,13 @@ def generator(ir, options):
     ig = IntegralGenerator(ir, backend)
 
     # Generate code ast for the tabulate_tensor body
-    parts = ig.generate()
+    with profiling.region("kernel ast", "code generation"):
+        parts = ig.generate()
 
     # Format code as string
-    body = format_indented_lines(parts.cs_format(ir.precision), 1)
+    with profiling.region("kernel formatting", "code generation") as counts:
+        body = format_indented_lines(parts.cs_format(ir.precision), 1)
+        counts["num_lines"] = body.count("\n") + 1
 
     # Generate generic FFCx code snippets and add specific parts
     code = {}
@@ -65,17 +76,94 @@ def generator(ir, options):
         code["enabled_coefficients_init"] = ""
         code["enabled_coefficients"] = L.Null()
 
+    if len(ir.tensor_shape) > 0:
+        code["tensor_shape_init"] = L.ArrayDecl(
+            "static int", f"tensor_shape_{ir.name}", values=ir.tensor_shape, sizes=len(ir.tensor_shape))
+        code["tensor_shape"] = f"tensor_shape_{ir.name}"
+    else:
+        code["tensor_shape_init"] = ""
+        code["tensor_shape"] = L.Null()
+
+    # Cost of a call, for buffer allocation and load balancing by the
+    # caller
+    code["flops"] = parts.flops()
+    code["scratch_bytes"] = scratch_bytes(parts)
+
     code["additional_includes_set"] = set()  # FIXME: Get this out of code[]
     code["tabulate_tensor"] = body
 
     if options["tabulate_tensor_void"]:
         code["tabulate_tensor"] = ""
+        code["flops"] = 0
+        code["scratch_bytes"] = 0
+
+    if manifest is not None:
+        manifest.add_integral(ir, L.StatementList([]) if options["tabulate_tensor_void"] else parts,
+                              code["flops"], code["scratch_bytes"])
+
+    # Function multiversioning, resolved by the dynamic loader
+    targets = [t.strip() for t in options["target_clones"].split(",") if t.strip()]
+    for target in targets:
+        if not re.match(r"^[A-Za-z0-9_.=-]+$", target):
+            raise ValueError(f"Invalid target '{target}' in option target_clones.")
+    if targets:
+        if "default" not in targets:
+            targets.append("default")
+        targets = ", ".join(f'"{t}"' for t in targets)
+        code["tabulate_tensor_attributes"] = f"__attribute__((target_clones({targets})))\n"
+    else:
+        code["tabulate_tensor_attributes"] = ""
+
+    # Call counters and timers, see ufcx_integral_statistics
+    if options["instrument_kernels"]:
+        code["statistics_init"] = ufcx_integrals.statistics_init.format(factory_name=factory_name)
+        code["statistics_begin"] = ufcx_integrals.statistics_begin
+        code["statistics_end"] = ufcx_integrals.statistics_end.format(factory_name=factory_name)
+        code["statistics"] = f"&statistics_{factory_name}"
+    else:
+        code["statistics_init"] = ""
+        code["statistics_begin"] = ""
+        code["statistics_end"] = ""
+        code["statistics"] = L.Null()
+
+    # Batched integration of functionals over many entities
+    if options["tabulate_functional"] and len(ir.tensor_shape) == 0:
+        code["tabulate_functional"] = tabulate_functional(ir, parts, options, code["tabulate_tensor_attributes"])
+        code["tabulate_functional_name"] = f"tabulate_functional_{factory_name}"
+    else:
+        code["tabulate_functional"] = ""
+        code["tabulate_functional_name"] = L.Null()
+
+    # Matrix-free action of bilinear forms on several vectors
+    if options["tabulate_action"] and len(ir.tensor_shape) == 2:
+        code["tabulate_action"] = tabulate_action(ir, options, code["tabulate_tensor_attributes"])
+        code["tabulate_action_name"] = f"tabulate_action_{factory_name}"
+    else:
+        code["tabulate_action"] = ""
+        code["tabulate_action_name"] = L.Null()
 
     implementation = ufcx_integrals.factory.format(
         factory_name=factory_name,
         enabled_coefficients=code["enabled_coefficients"],
         enabled_coefficients_init=code["enabled_coefficients_init"],
         tabulate_tensor=code["tabulate_tensor"],
+        tabulate_tensor_attributes=code["tabulate_tensor_attributes"],
+        statistics_init=code["statistics_init"],
+        statistics_begin=code["statistics_begin"],
+        statistics_end=code["statistics_end"],
+        statistics=code["statistics"],
+        tabulate_functional=code["tabulate_functional"],
+        tabulate_functional_name=code["tabulate_functional_name"],
+        tabulate_action=code["tabulate_action"],
+        tabulate_action_name=code["tabulate_action_name"],
+        tensor_shape_init=code["tensor_shape_init"],
+        tensor_shape=code["tensor_shape"],
+        rank=len(ir.tensor_shape),
+        num_coefficient_values=ir.num_coefficient_values,
+        num_constant_values=ir.num_constant_values,
+        num_coordinate_dofs=ir.num_coordinate_dofs,
+        flops=code["flops"],
+        scratch_bytes=code["scratch_bytes"],
         needs_facet_permutations="true" if ir.needs_facet_permutations else "false",
         scalar_type=options["scalar_type"],
         geom_type=scalar_to_value_type(options["scalar_type"]),
@@ -85,11 +173,88 @@ def generator(ir, options):
     return declaration, implementation
 
 
+def tabulate_functional(ir, parts: CNode, options: dict, attributes: str) -> str:
+    """Generate the batched kernel of a rank 0 integral, which sums tabulate_tensor over entities.
+
+    The tabulate_tensor body is inlined into the loop over entities, with
+    the arguments of each entity offset from the batched arrays, and the
+    contributions are added to FUNCTIONAL_PARTIAL_SUMS scalar partial
+    sums in turn.
+    """
+    # Entities per integral, and entity indices and facet permutations
+    # per entity
+    restrictions = 2 if ir.integral_type == "interior_facet" else 1
+    num_entity_indices = {"cell": 0, "exterior_facet": 1, "interior_facet": 2, "vertex": 1}[ir.integral_type]
+    num_permutations = 2 if ir.integral_type == "interior_facet" else 0
+
+    def offset(name, stride):
+        return f"{name}_entities + e * {stride}" if stride > 0 else f"{name}_entities"
+
+    scalar_type = options["scalar_type"]
+    if options["functional_compensated_summation"]:
+        accumulate = ufcx_integrals.accumulate_compensated.format(scalar_type=scalar_type)
+        compensation_init = ufcx_integrals.compensation_init.format(
+            scalar_type=scalar_type, num_partial_sums=FUNCTIONAL_PARTIAL_SUMS)
+        partial_sum = "sum[k] - compensation[k]"
+    else:
+        accumulate = ufcx_integrals.accumulate
+        compensation_init = ""
+        partial_sum = "sum[k]"
+
+    body = "" if options["tabulate_tensor_void"] else format_indented_lines(parts.cs_format(ir.precision), 4)
+    return ufcx_integrals.tabulate_functional.format(
+        factory_name=ir.name,
+        tabulate_tensor_attributes=attributes,
+        scalar_type=scalar_type,
+        geom_type=scalar_to_value_type(scalar_type),
+        num_partial_sums=FUNCTIONAL_PARTIAL_SUMS,
+        w=offset("w", ir.num_coefficient_values),
+        coordinate_dofs_stride=3 * restrictions * ir.num_coordinate_dofs,
+        entity_local_index=offset("entity_local_index", num_entity_indices),
+        quadrature_permutation=offset("quadrature_permutation", num_permutations),
+        tabulate_tensor=body,
+        compensation_init=compensation_init,
+        accumulate=accumulate,
+        partial_sum=partial_sum)
+
+
+def tabulate_action(ir, options: dict, attributes: str) -> str:
+    """Generate the kernel applying the element matrix of a bilinear integral to several vectors."""
+    if options["tabulate_tensor_void"]:
+        body = ""
+    else:
+        with profiling.region("action ast", "code generation"):
+            parts = IntegralGenerator(ir, FFCXBackend(ir, options), action=True).generate()
+        body = format_indented_lines(parts.cs_format(ir.precision), 1)
+
+    scalar_type = options["scalar_type"]
+    return ufcx_integrals.tabulate_action.format(
+        factory_name=ir.name,
+        tabulate_tensor_attributes=attributes,
+        scalar_type=scalar_type,
+        geom_type=scalar_to_value_type(scalar_type),
+        tabulate_action=body)
+
+
+def scratch_bytes(ast: CNode) -> int:
+    """Return the size in bytes of the (non-static) arrays declared in a kernel ast."""
+    nbytes = 0
+    for node in iter_nodes(ast):
+        if isinstance(node, ArrayDecl) and "static" not in node.typename.split():
+            nbytes += int(numpy.prod(pad_innermost_dim(node.sizes, node.padlen))) * c_type_size(node.typename)
+    return nbytes
+
+
 class IntegralGenerator(object):
-    def __init__(self, ir, backend):
+    def __init__(self, ir, backend, action=False):
         # Store ir
         self.ir = ir
 
+        # Generate the body of tabulate_action instead of
+        # tabulate_tensor, i.e. apply the element matrix of a bilinear
+        # form to vectors without forming it
+        self.action = action
+
         # Backend specific plugin with attributes
         # - language: for translating ufl operators to target language
         # - symbols: for translating ufl operators to target language
@@ -270,12 +435,10 @@ class IntegralGenerator(object):
         cells: Dict[Any, Set[Any]] = {t: set() for t in ufl_geometry.keys()}
 
         for integrand in self.ir.integrand.values():
-            for attr in integrand["factorization"].nodes.values():
-                mt = attr.get("mt")
-                if mt is not None:
-                    t = type(mt.terminal)
-                    if t in ufl_geometry:
-                        cells[t].add(mt.terminal.ufl_domain().ufl_cell().cellname())
+            for mt in integrand["factorization"].mt.values():
+                t = type(mt.terminal)
+                if t in ufl_geometry:
+                    cells[t].add(mt.terminal.ufl_domain().ufl_cell().cellname())
 
         parts = []
         for i, cell_list in cells.items():
@@ -378,11 +541,9 @@ class IntegralGenerator(object):
 
         use_symbol_array = True
 
-        for i, attr in F.nodes.items():
-            if attr['status'] != mode:
-                continue
-            v = attr['expression']
-            mt = attr.get('mt')
+        for i in F.nodes_with_status(mode):
+            v = F.expressions[i]
+            mt = F.mt.get(i)
 
             # Generate code only if the expression is not already in
             # cache
@@ -393,7 +554,7 @@ class IntegralGenerator(object):
                     # All finite element based terminals have table
                     # data, as well as some, but not all, of the
                     # symbolic geometric terminals
-                    tabledata = attr.get('tr')
+                    tabledata = F.tr.get(i)
 
                     # Backend specific modified terminal translation
                     vaccess = self.backend.access.get(mt.terminal, mt, tabledata, quadrature_rule)
@@ -410,9 +571,10 @@ class IntegralGenerator(object):
                     vops = [self.get_var(quadrature_rule, op) for op in v.ufl_operands]
 
                     # get parent operand
-                    pid = F.in_edges[i][0] if F.in_edges[i] else -1
+                    parents = F.in_edges(i)
+                    pid = parents[0] if parents else -1
                     if pid and pid > i:
-                        parent_exp = F.nodes.get(pid)['expression']
+                        parent_exp = F.expressions[pid]
                     else:
                         parent_exp = None
 
@@ -542,6 +704,9 @@ class IntegralGenerator(object):
         # RHS expressions grouped by LHS "dofmap"
         rhs_expressions = collections.defaultdict(list)
 
+        # Terms (A indices, fw, argument factors) of the action
+        action_terms = []
+
         block_rank = len(blockmap)
         blockdims = tuple(len(dofmap) for dofmap in blockmap)
 
@@ -569,7 +734,7 @@ class IntegralGenerator(object):
             # Get factor expression
             F = self.ir.integrand[quadrature_rule]["factorization"]
 
-            v = F.nodes[factor_index]['expression']
+            v = F.expressions[factor_index]
             f = self.get_var(quadrature_rule, v)
 
             # Quadrature weight was removed in representation, add it back now
@@ -613,6 +778,16 @@ class IntegralGenerator(object):
                     block_size = blockdata.ma_data[i].tabledata.block_size
                     A_indices.append(block_size * index + offset)
             rhs_expressions[tuple(A_indices)].append(B_rhs)
+            action_terms.append((A_indices, fw, arg_factors))
+
+        if self.action:
+            # All blocks are integrated in the quadrature loop, so the
+            # action needs no counterpart of the hoisting below, which
+            # only regroups the terms of the element tensor. Blocks of
+            # piecewise factors and tables are handled like the others.
+            assert quadrature_rule is not None, "Action of preintegrated blocks not implemented"
+            quadparts += self.generate_action_parts(blockdims, B_indices, action_terms)
+            return preparts, quadparts
 
         # List of statements to keep in the inner loop
         keep = collections.defaultdict(list)
@@ -681,6 +856,44 @@ class IntegralGenerator(object):
 
         return preparts, quadparts
 
+    def generate_action_parts(self, blockdims: Tuple, B_indices: List, terms: List) -> List[CNode]:
+        """Generate the action of a block on each of the vectors u, added to A.
+
+        For each vector, the trial function factors are summed over the
+        trial dofs first and then multiplied with the test function
+        factors, so the cost is linear rather than quadratic in the
+        number of dofs. Factors computed at the quadrature point (fw) are
+        shared by all vectors.
+        """
+        L = self.backend.language
+        scalar_type = self.backend.access.options["scalar_type"]
+        assert len(blockdims) == 2, "Action only implemented for bilinear forms"
+
+        num_test_dofs, num_trial_dofs = self.ir.tensor_shape
+        iv = self.backend.symbols.action_vector_index()
+        u = self.backend.symbols.action_vectors()
+        A = self.backend.symbols.element_tensor()
+
+        # Trial function values, by trial factor and dof, shared by the
+        # terms with the same trial factor and dof, and the test function
+        # contributions to each output dof
+        trial: Dict[Tuple[Any, Any], CNode] = {}
+        test: Dict[Any, List[CNode]] = collections.defaultdict(list)
+        for (test_dof, trial_dof), fw, (test_factor, trial_factor) in terms:
+            ut = trial.get((trial_factor, trial_dof))
+            if ut is None:
+                ut = self.new_temp_symbol("ut")
+                trial[(trial_factor, trial_dof)] = ut
+            test[test_dof].append(L.float_product([fw, test_factor, ut]))
+
+        body: List[CNode] = [L.VariableDecl(scalar_type, s, 0) for s in trial.values()]
+        body += [L.ForRange(B_indices[1], 0, blockdims[1], body=[
+            L.AssignAdd(s, L.float_product([f, u[iv * num_trial_dofs + d]])) for (f, d), s in trial.items()])]
+        body += [L.ForRange(B_indices[0], 0, blockdims[0], body=[
+            L.AssignAdd(A[iv * num_test_dofs + d], L.Sum(t)) for d, t in test.items()])]
+
+        return [L.ForRange(iv, 0, self.backend.symbols.num_action_vectors(), body=body)]
+
     def fuse_loops(self, definitions):
         """Merge a sequence of loops with the same iteration space into a single loop.
 
@@ -10,17 +10,19 @@ extern ufcx_integral {factory_name};
 factory = """
 // Code for integral {factory_name}
 
-void tabulate_tensor_{factory_name}({scalar_type}* restrict A,
+{statistics_init}{tabulate_tensor_attributes}void tabulate_tensor_{factory_name}({scalar_type}* restrict A,
                                     const {scalar_type}* restrict w,
                                     const {scalar_type}* restrict c,
                                     const {geom_type}* restrict coordinate_dofs,
                                     const int* restrict entity_local_index,
                                     const uint8_t* restrict quadrature_permutation)
 {{
-{tabulate_tensor}
-}}
+{statistics_begin}{tabulate_tensor}
+{statistics_end}}}
 
-{enabled_coefficients_init}
+{tabulate_functional}{tabulate_action}{enabled_coefficients_init}
+
+{tensor_shape_init}
 
 ufcx_integral {factory_name} =
 {{
@@ -28,7 +30,97 @@ ufcx_integral {factory_name} =
   .tabulate_tensor_{np_scalar_type} = tabulate_tensor_{factory_name},
   .needs_facet_permutations = {needs_facet_permutations},
   .coordinate_element = {coordinate_element},
+  .statistics = {statistics},
+  .rank = {rank},
+  .tensor_shape = {tensor_shape},
+  .num_coefficient_values = {num_coefficient_values},
+  .num_constant_values = {num_constant_values},
+  .num_coordinate_dofs = {num_coordinate_dofs},
+  .flops = {flops},
+  .scratch_bytes = {scratch_bytes},
+  .tabulate_functional_{np_scalar_type} = {tabulate_functional_name},
+  .tabulate_action_{np_scalar_type} = {tabulate_action_name},
 }};
 
 // End of code for integral {factory_name}
 """
+
+statistics_init = """static ufcx_integral_statistics statistics_{factory_name} = {{0, 0}};
+
+"""
+
+statistics_begin = """  struct timespec statistics_start, statistics_end;
+  clock_gettime(CLOCK_MONOTONIC, &statistics_start);
+"""
+
+statistics_end = """  clock_gettime(CLOCK_MONOTONIC, &statistics_end);
+  __atomic_fetch_add(&statistics_{factory_name}.num_calls, 1, __ATOMIC_RELAXED);
+  __atomic_fetch_add(&statistics_{factory_name}.time_ns,
+                     (uint64_t)(1000000000 * (statistics_end.tv_sec - statistics_start.tv_sec)
+                                + (statistics_end.tv_nsec - statistics_start.tv_nsec)),
+                     __ATOMIC_RELAXED);
+"""
+
+tabulate_functional = """{tabulate_tensor_attributes}void tabulate_functional_{factory_name}(
+                                    {scalar_type}* restrict result,
+                                    int64_t num_entities,
+                                    const {scalar_type}* restrict w_entities,
+                                    const {scalar_type}* restrict c,
+                                    const {geom_type}* restrict coordinate_dofs_entities,
+                                    const int* restrict entity_local_index_entities,
+                                    const uint8_t* restrict quadrature_permutation_entities)
+{{
+  // Independent scalar partial sums, so that consecutive entities do
+  // not wait for each other's additions
+  {scalar_type} sum[{num_partial_sums}] = {{0}};
+{compensation_init}  for (int64_t e0 = 0; e0 < num_entities; e0 += {num_partial_sums})
+  {{
+    for (int k = 0; k < {num_partial_sums} && e0 + k < num_entities; ++k)
+    {{
+      const int64_t e = e0 + k;
+      const {scalar_type}* restrict w = {w};
+      const {geom_type}* restrict coordinate_dofs = coordinate_dofs_entities + e * {coordinate_dofs_stride};
+      const int* restrict entity_local_index = {entity_local_index};
+      const uint8_t* restrict quadrature_permutation = {quadrature_permutation};
+      (void)w;
+      (void)entity_local_index;
+      (void)quadrature_permutation;
+      {scalar_type} A[1] = {{0}};
+      {{
+{tabulate_tensor}
+      }}
+{accumulate}
+    }}
+  }}
+  {scalar_type} total = 0;
+  for (int k = 0; k < {num_partial_sums}; ++k)
+    total += {partial_sum};
+  *result += total;
+}}
+
+"""
+
+tabulate_action = """{tabulate_tensor_attributes}void tabulate_action_{factory_name}(
+                                    {scalar_type}* restrict A,
+                                    int num_vectors,
+                                    const {scalar_type}* restrict u,
+                                    const {scalar_type}* restrict w,
+                                    const {scalar_type}* restrict c,
+                                    const {geom_type}* restrict coordinate_dofs,
+                                    const int* restrict entity_local_index,
+                                    const uint8_t* restrict quadrature_permutation)
+{{
+{tabulate_action}
+}}
+
+"""
+
+accumulate = """      sum[k] += A[0];"""
+
+compensation_init = """  {scalar_type} compensation[{num_partial_sums}] = {{0}};
+"""
+
+accumulate_compensated = """      const {scalar_type} y = A[0] - compensation[k];
+      const {scalar_type} t = sum[k] + y;
+      compensation[k] = (t - sum[k]) - y;
+      sum[k] = t;"""
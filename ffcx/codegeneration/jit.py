@@ -4,21 +4,33 @@
 #
 # SPDX-License-Identifier:    LGPL-3.0-or-later
 
+import concurrent.futures
+import hashlib
 import importlib
 import io
+import json
 import logging
 import os
+import platform
 import re
+import shlex
+import shutil
+import subprocess
+import sys
 import sysconfig
 import tempfile
+import threading
 import time
+import types
 from contextlib import redirect_stdout
 from pathlib import Path
 
 import cffi
+import numpy
 
 import ffcx
 import ffcx.naming
+import ffcx.profiling
 
 logger = logging.getLogger("ffcx")
 
@@ -43,17 +55,163 @@ UFC_INTEGRAL_DECL += '\n'.join(re.findall(r'typedef void ?\(ufcx_tabulate_tensor
 UFC_INTEGRAL_DECL += '\n'.join(re.findall(r'typedef void ?\(ufcx_tabulate_tensor_longdouble\).*?\);',
                                ufcx_h, re.DOTALL))
 
-UFC_INTEGRAL_DECL += '\n'.join(re.findall('typedef struct ufcx_integral.*?ufcx_integral;',
+UFC_INTEGRAL_DECL += '\n'.join(re.findall(r'typedef void ?\(ufcx_tabulate_functional_\w+\).*?\);', ufcx_h, re.DOTALL))
+UFC_INTEGRAL_DECL += '\n'.join(re.findall(r'typedef void ?\(ufcx_tabulate_action_\w+\).*?\);', ufcx_h, re.DOTALL))
+UFC_INTEGRAL_DECL += '\n'.join(re.findall('typedef struct ufcx_integral_statistics.*?ufcx_integral_statistics;',
+                                          ufcx_h, re.DOTALL))
+UFC_INTEGRAL_DECL += '\n'.join(re.findall(r'typedef struct ufcx_integral\b.*?ufcx_integral;',
                                           ufcx_h, re.DOTALL))
 UFC_EXPRESSION_DECL = '\n'.join(re.findall('typedef struct ufcx_expression.*?ufcx_expression;', ufcx_h, re.DOTALL))
 
+# Index of an ahead-of-time compiled bundle of forms, see ffcx.bundle
+BUNDLE_DECL = """
+typedef struct ffcx_bundle_entry
+{
+  const char* signature;
+  ufcx_form* form;
+} ffcx_bundle_entry;
+
+extern ffcx_bundle_entry ffcx_bundle_forms[];
+extern int ffcx_bundle_num_forms;
+"""
+
+# Registered bundles, mapping library path to (module, index)
+_bundles = {}
+
+# Flags appended to the compile arguments of the quick build in tiered
+# compilation. Later optimisation flags override earlier ones.
+TIERED_QUICK_COMPILE_ARGS = ["-O1"]
+
+# Background processes started by tiered compilation
+_background_builds = []
+
+# Option variants compared by compile_forms(tune=True). Options that
+# change the contract with the caller (e.g. assume_aligned) must be
+# requested explicitly.
+TUNING_VARIANTS = [{"padlen": 1}, {"padlen": 4}, {"padlen": 8}]
+
+# Minimum time (in seconds) each kernel is timed for when tuning
+TUNING_MIN_TIME = 5e-3
+
+# Calls of each kernel on synthetic input to record the profile of
+# compile_forms(pgo=True)
+PGO_TRAINING_CALLS = 10000
+
+# Calls the kernels of an integral in a loop, so that the call overhead
+# of Python does not distort the timing of small kernels
+TUNING_RUNNER_DECL = """
+void ffcx_tuning_run(const void* integral, int scalar, void* A, const void* w, const void* c,
+                     const void* coordinate_dofs, const int* entity_local_index,
+                     const uint8_t* quadrature_permutation, long calls);
+"""
+
+TUNING_RUNNER_SOURCE = """
+#include <ufcx.h>
+
+#define RUN(name, scalar_t, geom_t)                                                         \\
+  for (long i = 0; i < calls; ++i)                                                         \\
+    itg->tabulate_tensor_##name((scalar_t*)A, (const scalar_t*)w, (const scalar_t*)c,       \\
+                                (const geom_t*)coordinate_dofs, entity_local_index,        \\
+                                quadrature_permutation)
+
+void ffcx_tuning_run(const void* integral, int scalar, void* A, const void* w, const void* c,
+                     const void* coordinate_dofs, const int* entity_local_index,
+                     const uint8_t* quadrature_permutation, long calls)
+{
+  const ufcx_integral* itg = integral;
+  switch (scalar)
+  {
+  case 0:
+    RUN(float32, float, float);
+    break;
+  case 1:
+    RUN(float64, double, double);
+    break;
+  case 2:
+    RUN(longdouble, long double, long double);
+    break;
+  case 3:
+    RUN(complex64, float _Complex, float);
+    break;
+  case 4:
+    RUN(complex128, double _Complex, double);
+    break;
+  }
+}
+"""
+
+# NumPy types of the scalar argument of ffcx_tuning_run
+_TUNING_SCALARS = ["float32", "float64", "longdouble", "complex64", "complex128"]
+
+# Loaded tuning runners, by library path
+_tuning_runners = {}
+
+# State of the asynchronous compilation API
+_async_lock = threading.Lock()
+_async_pending = {}
+_async_executor = None
+
+
+# Options that do not change the generated code
+_NON_SIGNATURE_OPTIONS = ("verbosity", "ir_workers")
+
 
 def _compute_option_signature(options):
     """Return options signature (some options should not affect signature)."""
-    return str(sorted(options.items()))
+    return str(sorted((k, v) for k, v in options.items() if k not in _NON_SIGNATURE_OPTIONS))
+
+
+def bundle_signature(form, options):
+    """Return the signature under which a form is stored in a bundle."""
+    return ffcx.naming.compute_signature([form], _compute_option_signature(options))
+
+
+def register_bundle(filename):
+    """Make the forms of an ahead-of-time compiled bundle available to ``compile_forms``.
+
+    Bundles listed in the ``FFCX_BUNDLES`` environment variable
+    (separated by ``os.pathsep``) are registered automatically.
+    """
+    path = str(Path(filename).resolve())
+    if path in _bundles:
+        return _bundles[path][0]
+
+    ffi = cffi.FFI()
+    ffi.cdef(UFC_HEADER_DECL.format("double") + UFC_ELEMENT_DECL + UFC_DOFMAP_DECL + UFC_INTEGRAL_DECL
+             + UFC_FORM_DECL + BUNDLE_DECL)
+    lib = ffi.dlopen(path)
+
+    module = types.ModuleType(Path(path).stem)
+    module.__file__ = path
+    module.ffi = ffi
+    module.lib = lib
+
+    index = {}
+    for i in range(lib.ffcx_bundle_num_forms):
+        entry = lib.ffcx_bundle_forms[i]
+        index[ffi.string(entry.signature).decode()] = entry.form[0]
+    _bundles[path] = (module, index)
+    logger.info(f"Registered bundle {path} with {len(index)} forms.")
+
+    return module
+
+
+def _find_bundled_forms(forms, options):
+    """Look up all forms in one of the registered bundles."""
+    for filename in os.environ.get("FFCX_BUNDLES", "").split(os.pathsep):
+        if filename:
+            register_bundle(filename)
+    if not _bundles:
+        return None, None
 
+    signatures = [bundle_signature(form, options) for form in forms]
+    for module, index in _bundles.values():
+        if all(s in index for s in signatures):
+            return [index[s] for s in signatures], module
+    return None, None
 
-def get_cached_module(module_name, object_names, cache_dir, timeout):
+
+def get_cached_module(module_name, object_names, cache_dir, timeout, decl=None, backend="cffi"):
     """Look for an existing C file and wait for compilation, or if it does not exist, create it."""
     cache_dir = Path(cache_dir)
     c_filename = cache_dir.joinpath(module_name).with_suffix(".c")
@@ -68,21 +226,11 @@ def get_cached_module(module_name, object_names, cache_dir, timeout):
         return None, None
     except FileExistsError:
         logger.info("Cached C file already exists: " + str(c_filename))
-        finder = importlib.machinery.FileFinder(
-            str(cache_dir), (importlib.machinery.ExtensionFileLoader, importlib.machinery.EXTENSION_SUFFIXES))
-        finder.invalidate_caches()
 
         # Now, wait for ready
         for i in range(timeout):
             if os.path.exists(ready_name):
-                spec = finder.find_spec(module_name)
-                if spec is None:
-                    raise ModuleNotFoundError("Unable to find JIT module.")
-                compiled_module = importlib.util.module_from_spec(spec)
-                spec.loader.exec_module(compiled_module)
-
-                compiled_objects = [getattr(compiled_module.lib, name) for name in object_names]
-                return compiled_objects, compiled_module
+                return _load_objects(cache_dir, module_name, object_names, decl, backend)
 
             logger.info(f"Waiting for {ready_name} to appear.")
             time.sleep(1)
@@ -90,31 +238,30 @@ def get_cached_module(module_name, object_names, cache_dir, timeout):
         Try cleaning cache (e.g. remove {c_filename}) or increase timeout option.""")
 
 
-def _compilation_signature(cffi_extra_compile_args=None, cffi_debug=None):
+def _compilation_signature(cffi_extra_compile_args=None, cffi_debug=None, backend="cffi"):
     """Compute the compilation-inputs part of the signature.
 
     Used to avoid cache conflicts across Python versions, architectures, installs.
 
     - SOABI includes platform, Python version, debug flags
     - CFLAGS includes prefixes, arch targets
+    - backend distinguishes CFFI extension modules from plain shared libraries
     """
     return (
         str(cffi_extra_compile_args)
         + str(cffi_debug)
         + sysconfig.get_config_var("CFLAGS")
         + sysconfig.get_config_var("SOABI")
+        + backend
     )
 
 
-def compile_elements(elements, options=None, cache_dir=None, timeout=10, cffi_extra_compile_args=None,
-                     cffi_verbose=False, cffi_debug=None, cffi_libraries=None):
-    """Compile a list of UFL elements and dofmaps into Python objects."""
-    p = ffcx.options.get_options(options)
-
+def _elements_module(elements, options, cffi_extra_compile_args, cffi_debug, backend):
+    """Return the module name, object names and declarations of the module of a list of elements."""
     # Get a signature for these elements
     module_name = 'libffcx_elements_' + \
-        ffcx.naming.compute_signature(elements, _compute_option_signature(p)
-                                      + _compilation_signature(cffi_extra_compile_args, cffi_debug))
+        ffcx.naming.compute_signature(elements, _compute_option_signature(options)
+                                      + _compilation_signature(cffi_extra_compile_args, cffi_debug, backend))
 
     names = []
     for e in elements:
@@ -123,9 +270,25 @@ def compile_elements(elements, options=None, cache_dir=None, timeout=10, cffi_ex
         name = ffcx.naming.dofmap_name(e, module_name)
         names.append(name)
 
+    decl = UFC_HEADER_DECL.format(options["scalar_type"]) + UFC_ELEMENT_DECL + UFC_DOFMAP_DECL
+    element_template = "extern ufcx_finite_element {name};\n"
+    dofmap_template = "extern ufcx_dofmap {name};\n"
+    for i in range(len(elements)):
+        decl += element_template.format(name=names[i * 2])
+        decl += dofmap_template.format(name=names[i * 2 + 1])
+
+    return module_name, names, decl
+
+
+def compile_elements(elements, options=None, cache_dir=None, timeout=10, cffi_extra_compile_args=None,
+                     cffi_verbose=False, cffi_debug=None, cffi_libraries=None, backend="cffi"):
+    """Compile a list of UFL elements and dofmaps into Python objects."""
+    p = ffcx.options.get_options(options)
+    module_name, names, decl = _elements_module(elements, p, cffi_extra_compile_args, cffi_debug, backend)
+
     if cache_dir is not None:
         cache_dir = Path(cache_dir)
-        obj, mod = get_cached_module(module_name, names, cache_dir, timeout)
+        obj, mod = get_cached_module(module_name, names, cache_dir, timeout, decl, backend)
         if obj is not None:
             # Pair up elements with dofmaps
             obj = list(zip(obj[::2], obj[1::2]))
@@ -134,69 +297,333 @@ def compile_elements(elements, options=None, cache_dir=None, timeout=10, cffi_ex
         cache_dir = Path(tempfile.mkdtemp())
 
     try:
-        decl = UFC_HEADER_DECL.format(p["scalar_type"]) + UFC_ELEMENT_DECL + UFC_DOFMAP_DECL
-        element_template = "extern ufcx_finite_element {name};\n"
-        dofmap_template = "extern ufcx_dofmap {name};\n"
-        for i in range(len(elements)):
-            decl += element_template.format(name=names[i * 2])
-            decl += dofmap_template.format(name=names[i * 2 + 1])
-
         impl = _compile_objects(decl, elements, names, module_name, p, cache_dir,
-                                cffi_extra_compile_args, cffi_verbose, cffi_debug, cffi_libraries)
+                                cffi_extra_compile_args, cffi_verbose, cffi_debug, cffi_libraries, backend)
     except Exception:
         # remove c file so that it will not timeout next time
         c_filename = cache_dir.joinpath(module_name + ".c")
         os.replace(c_filename, c_filename.with_suffix(".c.failed"))
         raise
 
-    objects, module = _load_objects(cache_dir, module_name, names)
+    objects, module = _load_objects(cache_dir, module_name, names, decl, backend)
     # Pair up elements with dofmaps
     objects = list(zip(objects[::2], objects[1::2]))
     return objects, module, (decl, impl)
 
 
-def compile_forms(forms, options=None, cache_dir=None, timeout=10, cffi_extra_compile_args=None,
-                  cffi_verbose=False, cffi_debug=None, cffi_libraries=None):
-    """Compile a list of UFL forms into UFC Python objects."""
-    p = ffcx.options.get_options(options)
-
+def _forms_module(forms, options, cffi_extra_compile_args, cffi_debug, backend, pgo=False):
+    """Return the module name, object names and declarations of the module of a list of forms."""
     # Get a signature for these forms
     module_name = 'libffcx_forms_' + \
-        ffcx.naming.compute_signature(forms, _compute_option_signature(p)
-                                      + _compilation_signature(cffi_extra_compile_args, cffi_debug))
+        ffcx.naming.compute_signature(forms, _compute_option_signature(options)
+                                      + _compilation_signature(cffi_extra_compile_args, cffi_debug, backend)
+                                      + _pgo_signature(pgo))
 
     form_names = [ffcx.naming.form_name(form, i, module_name) for i, form in enumerate(forms)]
 
+    decl = UFC_HEADER_DECL.format(options["scalar_type"]) + UFC_ELEMENT_DECL + UFC_DOFMAP_DECL + \
+        UFC_INTEGRAL_DECL + UFC_FORM_DECL
+
+    form_template = "extern ufcx_form {name};\n"
+    for name in form_names:
+        decl += form_template.format(name=name)
+
+    return module_name, form_names, decl
+
+
+def compile_forms(forms, options=None, cache_dir=None, timeout=10, cffi_extra_compile_args=None,
+                  cffi_verbose=False, cffi_debug=None, cffi_libraries=None, backend="cffi", tiered=False,
+                  tune=False, pgo=False):
+    """Compile a list of UFL forms into UFC Python objects.
+
+    If all forms are found in a registered bundle (see
+    ``register_bundle``), they are returned without compilation.
+
+    Options
+    ----------
+    backend
+        How the generated C code is built and loaded. ``"cffi"`` builds
+        a Python extension module through ``cffi`` (and setuptools).
+        ``"direct"`` invokes the C compiler directly to build a plain
+        shared library, which is then opened with ``ffi.dlopen``. The
+        latter avoids the setuptools overhead for small forms.
+    tiered
+        If True (and ``cache_dir`` is given), do not wait for the
+        optimised build. Return a module compiled with
+        ``TIERED_QUICK_COMPILE_ARGS`` appended to the compile arguments,
+        and build the optimised module in a background process. Later
+        calls return the optimised module once it is ready in the cache.
+    tune
+        If True, or a list of dictionaries of options, compile the forms
+        with each of these option variants (by default
+        ``TUNING_VARIANTS``), time their kernels on synthetic input and
+        return the fastest module. The choice is stored in ``cache_dir``
+        for this CPU model, so later calls only compile the winner. The
+        variants must not change the interface of the kernels (e.g. the
+        scalar type).
+    pgo
+        If True, or a ``(name, workload)`` pair, build the module with
+        profile-guided optimisation (requires ``backend="direct"`` and
+        GCC). An instrumented module is built first and exercised,
+        either by calling every kernel ``PGO_TRAINING_CALLS`` times on
+        synthetic input or by calling ``workload(compiled_forms,
+        module)`` with the instrumented module, which must not be used
+        after the call. The module is then rebuilt with the recorded
+        profile and cached under a signature that includes ``name``, so
+        each distinct workload needs its own name.
+
+    """
+    p = ffcx.options.get_options(options)
+
+    # Use ahead-of-time compiled forms if available
+    obj, mod = _find_bundled_forms(forms, p)
+    if obj is not None:
+        return obj, mod, (None, None)
+
+    if tune:
+        if cache_dir is None:
+            cache_dir = tempfile.mkdtemp()
+        p = _tuned_options(forms, p, Path(cache_dir), TUNING_VARIANTS if tune is True else tune, timeout,
+                           cffi_extra_compile_args, cffi_verbose, cffi_debug, cffi_libraries, backend)
+
+    workload = isinstance(pgo, tuple) and len(pgo) == 2 and isinstance(pgo[0], str) and callable(pgo[1])
+    if not (isinstance(pgo, bool) or workload):
+        raise ValueError("Option pgo must be True, False or a (name, workload) pair.")
+    if pgo and backend != "direct":
+        raise ValueError("Profile-guided optimisation requires the direct JIT backend.")
+    if pgo and tiered:
+        raise ValueError("Profile-guided optimisation cannot be combined with tiered compilation.")
+
+    module_name, form_names, decl = _forms_module(forms, p, cffi_extra_compile_args, cffi_debug, backend, pgo)
+
+    if tiered and cache_dir is not None:
+        quick_compile_args = list(cffi_extra_compile_args or []) + TIERED_QUICK_COMPILE_ARGS
+        quick_module_name = 'libffcx_forms_' + \
+            ffcx.naming.compute_signature(forms, _compute_option_signature(p)
+                                          + _compilation_signature(quick_compile_args, cffi_debug, backend))
+        return _compile_tiered(decl, forms, form_names, module_name, quick_module_name, p, Path(cache_dir),
+                               timeout, cffi_extra_compile_args, cffi_verbose, cffi_debug, cffi_libraries, backend)
+
     if cache_dir is not None:
         cache_dir = Path(cache_dir)
-        obj, mod = get_cached_module(module_name, form_names, cache_dir, timeout)
+        obj, mod = get_cached_module(module_name, form_names, cache_dir, timeout, decl, backend)
         if obj is not None:
             return obj, mod, (None, None)
     else:
         cache_dir = Path(tempfile.mkdtemp())
 
     try:
-        decl = UFC_HEADER_DECL.format(p["scalar_type"]) + UFC_ELEMENT_DECL + UFC_DOFMAP_DECL + \
-            UFC_INTEGRAL_DECL + UFC_FORM_DECL
-
-        form_template = "extern ufcx_form {name};\n"
-        for name in form_names:
-            decl += form_template.format(name=name)
-
-        impl = _compile_objects(decl, forms, form_names, module_name, p, cache_dir,
-                                cffi_extra_compile_args, cffi_verbose, cffi_debug, cffi_libraries)
+        if pgo:
+            impl = _compile_pgo(decl, forms, form_names, module_name, p, cache_dir, cffi_extra_compile_args,
+                                cffi_verbose, cffi_debug, cffi_libraries, pgo)
+        else:
+            impl = _compile_objects(decl, forms, form_names, module_name, p, cache_dir,
+                                    cffi_extra_compile_args, cffi_verbose, cffi_debug, cffi_libraries, backend)
     except Exception:
         # remove c file so that it will not timeout next time
         c_filename = cache_dir.joinpath(module_name + ".c")
         os.replace(c_filename, c_filename.with_suffix(".c.failed"))
         raise
 
-    obj, module = _load_objects(cache_dir, module_name, form_names)
+    obj, module = _load_objects(cache_dir, module_name, form_names, decl, backend)
     return obj, module, (decl, impl)
 
 
+def _pgo_signature(pgo):
+    """Return the part of the module signature that identifies the profiling workload."""
+    if not pgo:
+        return ""
+    elif pgo is True:
+        return "pgo"
+    else:
+        return "pgo:" + pgo[0]
+
+
+def _compile_pgo(decl, forms, form_names, module_name, options, cache_dir, cffi_extra_compile_args, cffi_verbose,
+                 cffi_debug, cffi_libraries, pgo):
+    """Build a shared library with profile-guided optimisation.
+
+    Both builds compile the same C file with the same ``-dumpbase``,
+    so that GCC finds the profile of the instrumented build (in
+    ``<module_name>.profile`` in the cache) when rebuilding.
+    """
+    code_body = _generate_code(forms, module_name, options)
+    c_filename = cache_dir.joinpath(module_name + ".c")
+    profile_dir = cache_dir.joinpath(module_name + ".profile")
+    shutil.rmtree(profile_dir, ignore_errors=True)
+    profile_args = list(cffi_extra_compile_args or []) + ["-dumpbase", module_name, f"-fprofile-dir={profile_dir}"]
+
+    # Build and exercise the instrumented library. The profile is
+    # written when the library is unloaded.
+    instrumented_name = module_name + "_instrumented"
+    with open(c_filename, "w") as f:
+        f.write(code_body)
+    with ffcx.profiling.region("C compilation", "jit", module=instrumented_name, backend="direct"):
+        _link_shared_library([c_filename], cache_dir.joinpath(instrumented_name + ".so"),
+                             profile_args + ["-fprofile-generate", "-fprofile-update=prefer-atomic"], cffi_debug,
+                             cffi_libraries)
+    try:
+        compiled_forms, module = _load_shared_library_objects(cache_dir, instrumented_name, form_names, decl)
+        with ffcx.profiling.region("PGO training", "jit", module=module_name):
+            if pgo is True:
+                for run, args in _synthetic_calls(compiled_forms, module, options["scalar_type"],
+                                                  _tuning_runner(cache_dir)):
+                    run(*args, PGO_TRAINING_CALLS)
+            else:
+                pgo[1](compiled_forms, module)
+        del compiled_forms
+        module.ffi.dlclose(module.lib)
+    finally:
+        os.remove(cache_dir.joinpath(instrumented_name + ".so"))
+
+    if not any(profile_dir.rglob("*.gcda")):
+        raise RuntimeError(f"No profile was recorded in {profile_dir}. Profile-guided optimisation requires GCC.")
+
+    _build_module(decl, code_body, module_name, cache_dir,
+                  profile_args + ["-fprofile-use", "-fprofile-partial-training"], cffi_verbose, cffi_debug,
+                  cffi_libraries, "direct")
+    shutil.rmtree(profile_dir, ignore_errors=True)
+    return code_body
+
+
+def _cpu_model():
+    """Return a description of the CPU, to which tuning decisions are specific."""
+    try:
+        with open("/proc/cpuinfo") as f:
+            for line in f:
+                if line.startswith("model name"):
+                    return line.split(":", 1)[1].strip()
+    except OSError:
+        pass
+    return platform.processor() or platform.machine()
+
+
+def _tuned_options(forms, options, cache_dir, variants, timeout, cffi_extra_compile_args, cffi_verbose, cffi_debug,
+                   cffi_libraries, backend):
+    """Return the options of the fastest variant for the forms, timing the variants unless done before."""
+    key = ffcx.naming.compute_signature(forms, _compute_option_signature(options)
+                                        + _compilation_signature(cffi_extra_compile_args, cffi_debug, backend)
+                                        + json.dumps(variants, sort_keys=True) + _cpu_model())
+    filename = cache_dir.joinpath(f"libffcx_tuning_{key}.json")
+    try:
+        with open(filename, "r") as f:
+            winner = json.load(f)["options"]
+        logger.info(f"Using tuned options {winner} from {filename}.")
+        return {**options, **winner}
+    except FileNotFoundError:
+        pass
+
+    runner = _tuning_runner(cache_dir)
+    results = []
+    for variant in variants:
+        variant_options = {**options, **variant}
+        compiled_forms, module, _ = compile_forms(forms, variant_options, cache_dir, timeout,
+                                                  cffi_extra_compile_args, cffi_verbose, cffi_debug,
+                                                  cffi_libraries, backend)
+        seconds = _time_forms(compiled_forms, module, variant_options["scalar_type"], runner)
+        logger.info(f"Tuning variant {variant}: {seconds * 1e9:.1f} ns per call of all kernels.")
+        results.append({"options": variant, "seconds_per_call": seconds})
+    winner = min(results, key=lambda r: r["seconds_per_call"])["options"]
+
+    # Write the decision atomically, as other processes may be reading it
+    fd, tmp_filename = tempfile.mkstemp(suffix=".json", dir=cache_dir)
+    with os.fdopen(fd, "w") as f:
+        json.dump({"cpu": _cpu_model(), "variants": results, "options": winner}, f, indent=2)
+    os.replace(tmp_filename, filename)
+
+    return {**options, **winner}
+
+
+def _tuning_runner(cache_dir):
+    """Build (once per cache directory) and load the library that calls kernels in a loop."""
+    name = "libffcx_tuning_runner_" + hashlib.sha1((TUNING_RUNNER_SOURCE + ufcx_h).encode()).hexdigest()
+    lib_filename = cache_dir.joinpath(name + ".so")
+    if str(lib_filename) not in _tuning_runners:
+        if not lib_filename.exists():
+            fd, c_filename = tempfile.mkstemp(suffix=".c", dir=cache_dir)
+            with os.fdopen(fd, "w") as f:
+                f.write(TUNING_RUNNER_SOURCE)
+            try:
+                _link_shared_library([c_filename], lib_filename, None, False, None)
+            finally:
+                os.remove(c_filename)
+        ffi = cffi.FFI()
+        ffi.cdef(TUNING_RUNNER_DECL)
+        _tuning_runners[str(lib_filename)] = (ffi, ffi.dlopen(str(lib_filename)))
+    return _tuning_runners[str(lib_filename)]
+
+
+def _time_forms(compiled_forms, module, scalar_type, runner):
+    """Return the sum over all kernels of the forms of the time per call on synthetic input, in seconds."""
+    return sum(_time_kernel(run, args) for run, args in _synthetic_calls(compiled_forms, module, scalar_type, runner))
+
+
+def _synthetic_calls(compiled_forms, module, scalar_type, runner):
+    """Generate the tuning runner and its arguments for calling each kernel of the forms.
+
+    Coefficients, constants and coordinates are random, and the sizes
+    of the arrays are taken from the ufcx_integral.
+    """
+    ffi, lib = runner
+    np_type = ffcx.naming.cdtype_to_numpy(scalar_type)
+    geom_type = ffcx.naming.cdtype_to_numpy(ffcx.naming.scalar_to_value_type(scalar_type))
+    rng = numpy.random.default_rng(0)
+
+    for form in compiled_forms:
+        for integral_type in (module.lib.cell, module.lib.exterior_facet, module.lib.interior_facet):
+            restrictions = 2 if integral_type == module.lib.interior_facet else 1
+            integrals = form.integrals(integral_type)
+            for k in range(form.num_integrals(integral_type)):
+                integral = integrals[k]
+                A = numpy.zeros(numpy.prod([integral.tensor_shape[i] for i in range(integral.rank)], dtype=int),
+                                dtype=np_type)
+                w = rng.random(integral.num_coefficient_values + 1).astype(np_type)
+                c = rng.random(integral.num_constant_values + 1).astype(np_type)
+                x = rng.random(3 * restrictions * integral.num_coordinate_dofs).astype(geom_type)
+                entity_local_index = numpy.zeros(2, dtype=numpy.intc)
+                quadrature_permutation = numpy.zeros(2, dtype=numpy.uint8)
+                args = [ffi.cast("const void*", int(module.ffi.cast("uintptr_t", integral))),
+                        _TUNING_SCALARS.index(np_type)]
+                args += [ffi.cast("void*", a.ctypes.data) for a in (A, w, c, x)]
+                args += [ffi.cast("const int*", entity_local_index.ctypes.data),
+                         ffi.cast("const uint8_t*", quadrature_permutation.ctypes.data)]
+                yield lib.ffcx_tuning_run, args
+
+
+def _time_kernel(run, args):
+    """Return the time per call of a kernel, called through the tuning runner."""
+    def elapsed(calls):
+        t0 = time.perf_counter()
+        run(*args, calls)
+        return time.perf_counter() - t0
+
+    # Double the number of calls until the timing is long enough to be
+    # reliable, then take the best of three
+    calls = 1
+    while elapsed(calls) < TUNING_MIN_TIME and calls < 2**30:
+        calls *= 2
+    return min(elapsed(calls) for i in range(3)) / calls
+
+
+def _expressions_module(expressions, options, cffi_extra_compile_args, cffi_debug, backend):
+    """Return the module name, object names and declarations of the module of a list of expressions."""
+    module_name = 'libffcx_expressions_' + \
+        ffcx.naming.compute_signature(expressions, _compute_option_signature(options)
+                                      + _compilation_signature(cffi_extra_compile_args, cffi_debug, backend))
+    expr_names = [ffcx.naming.expression_name(expression, module_name) for expression in expressions]
+
+    decl = UFC_HEADER_DECL.format(options["scalar_type"]) + UFC_ELEMENT_DECL + UFC_DOFMAP_DECL + \
+        UFC_INTEGRAL_DECL + UFC_FORM_DECL + UFC_EXPRESSION_DECL
+
+    expression_template = "extern ufcx_expression {name};\n"
+    for name in expr_names:
+        decl += expression_template.format(name=name)
+
+    return module_name, expr_names, decl
+
+
 def compile_expressions(expressions, options=None, cache_dir=None, timeout=10, cffi_extra_compile_args=None,
-                        cffi_verbose=False, cffi_debug=None, cffi_libraries=None):
+                        cffi_verbose=False, cffi_debug=None, cffi_libraries=None, backend="cffi"):
     """Compile a list of UFL expressions into UFC Python objects.
 
     Options
@@ -206,54 +633,142 @@ def compile_expressions(expressions, options=None, cache_dir=None, timeout=10, c
 
     """
     p = ffcx.options.get_options(options)
-
-    module_name = 'libffcx_expressions_' + \
-        ffcx.naming.compute_signature(expressions, _compute_option_signature(p)
-                                      + _compilation_signature(cffi_extra_compile_args, cffi_debug))
-    expr_names = [ffcx.naming.expression_name(expression, module_name) for expression in expressions]
+    module_name, expr_names, decl = _expressions_module(expressions, p, cffi_extra_compile_args, cffi_debug,
+                                                        backend)
 
     if cache_dir is not None:
         cache_dir = Path(cache_dir)
-        obj, mod = get_cached_module(module_name, expr_names, cache_dir, timeout)
+        obj, mod = get_cached_module(module_name, expr_names, cache_dir, timeout, decl, backend)
         if obj is not None:
             return obj, mod, (None, None)
     else:
         cache_dir = Path(tempfile.mkdtemp())
 
     try:
-        decl = UFC_HEADER_DECL.format(p["scalar_type"]) + UFC_ELEMENT_DECL + UFC_DOFMAP_DECL + \
-            UFC_INTEGRAL_DECL + UFC_FORM_DECL + UFC_EXPRESSION_DECL
-
-        expression_template = "extern ufcx_expression {name};\n"
-        for name in expr_names:
-            decl += expression_template.format(name=name)
-
         impl = _compile_objects(decl, expressions, expr_names, module_name, p, cache_dir,
-                                cffi_extra_compile_args, cffi_verbose, cffi_debug, cffi_libraries)
+                                cffi_extra_compile_args, cffi_verbose, cffi_debug, cffi_libraries, backend)
     except Exception:
         # remove c file so that it will not timeout next time
         c_filename = cache_dir.joinpath(module_name + ".c")
         os.replace(c_filename, c_filename.with_suffix(".c.failed"))
         raise
 
-    obj, module = _load_objects(cache_dir, module_name, expr_names)
+    obj, module = _load_objects(cache_dir, module_name, expr_names, decl, backend)
     return obj, module, (decl, impl)
 
 
+def compile_elements_async(elements, options=None, cache_dir=None, executor=None, **kwargs):
+    """Compile UFL elements asynchronously, see ``compile_forms_async``."""
+    return _compile_async(compile_elements, _elements_module, elements, options, cache_dir, executor, kwargs)
+
+
+def compile_forms_async(forms, options=None, cache_dir=None, executor=None, **kwargs):
+    """Compile a list of UFL forms asynchronously.
+
+    Returns a ``concurrent.futures.Future`` whose result is the tuple
+    returned by ``compile_forms``. Remaining keyword arguments are
+    passed on to ``compile_forms``.
+
+    The compilation runs in ``executor``, by default a process pool
+    shared by all asynchronous requests, and the module is then loaded
+    from ``cache_dir`` (a temporary directory if not given) in this
+    process. With a process pool the UFL objects must be picklable;
+    a ``ThreadPoolExecutor`` can be passed otherwise. Requests for the
+    same module in the same cache directory that are still in flight
+    share one future. Tiered compilation, tuning and profile-guided
+    optimisation are not supported asynchronously.
+
+    """
+    return _compile_async(compile_forms, _forms_module, forms, options, cache_dir, executor, kwargs)
+
+
+def compile_expressions_async(expressions, options=None, cache_dir=None, executor=None, **kwargs):
+    """Compile UFL expressions asynchronously, see ``compile_forms_async``."""
+    return _compile_async(compile_expressions, _expressions_module, expressions, options, cache_dir, executor,
+                          kwargs)
+
+
+def _compile_async(compile_function, module_function, ufl_objects, options, cache_dir, executor, kwargs):
+    global _async_executor
+
+    # These choose the module by other means than its signature
+    unsupported = [name for name in ("tiered", "tune", "pgo") if kwargs.get(name)]
+    if unsupported:
+        raise ValueError(f"Asynchronous compilation does not support {', '.join(unsupported)}.")
+
+    p = ffcx.options.get_options(options)
+    cache_dir = Path(cache_dir) if cache_dir is not None else Path(tempfile.mkdtemp())
+    backend = kwargs.get("backend", "cffi")
+    module_name, object_names, decl = module_function(ufl_objects, p, kwargs.get("cffi_extra_compile_args"),
+                                                      kwargs.get("cffi_debug"), backend)
+    key = (module_name, str(cache_dir.resolve()))
+
+    with _async_lock:
+        if key in _async_pending:
+            return _async_pending[key]
+        if executor is None:
+            if _async_executor is None:
+                _async_executor = concurrent.futures.ProcessPoolExecutor()
+            executor = _async_executor
+
+        future = concurrent.futures.Future()
+        future.set_running_or_notify_cancel()
+        _async_pending[key] = future
+
+    def load(worker_future):
+        # The worker has built the module in the cache
+        try:
+            code = worker_future.result()
+            objects, module = _load_objects(cache_dir, module_name, object_names, decl, backend)
+            if compile_function is compile_elements:
+                # Pair up elements with dofmaps
+                objects = list(zip(objects[::2], objects[1::2]))
+            future.set_result((objects, module, code))
+        except Exception as e:
+            future.set_exception(e)
+        finally:
+            with _async_lock:
+                del _async_pending[key]
+
+    try:
+        worker_future = executor.submit(_compile_in_worker, compile_function.__name__, ufl_objects, options,
+                                        str(cache_dir), kwargs)
+    except Exception:
+        with _async_lock:
+            del _async_pending[key]
+        raise
+    worker_future.add_done_callback(load)
+    return future
+
+
+def _compile_in_worker(function_name, ufl_objects, options, cache_dir, kwargs):
+    """Compile into the cache and return the generated code (the module cannot be pickled)."""
+    _, _, code = globals()[function_name](ufl_objects, options, cache_dir, **kwargs)
+    return code
+
+
 def _compile_objects(decl, ufl_objects, object_names, module_name, options, cache_dir,
-                     cffi_extra_compile_args, cffi_verbose, cffi_debug, cffi_libraries):
+                     cffi_extra_compile_args, cffi_verbose, cffi_debug, cffi_libraries, backend="cffi"):
 
+    code_body = _generate_code(ufl_objects, module_name, options)
+    _build_module(decl, code_body, module_name, cache_dir, cffi_extra_compile_args, cffi_verbose, cffi_debug,
+                  cffi_libraries, backend)
+    return code_body
+
+
+def _generate_code(ufl_objects, module_name, options):
+    """Generate the C implementation of UFL objects for a JIT module."""
     import ffcx.compiler
 
     # JIT uses module_name as prefix, which is needed to make names of all struct/function
     # unique across modules
     _, code_body = ffcx.compiler.compile_ufl_objects(ufl_objects, prefix=module_name, options=options)
+    return code_body
 
-    ffibuilder = cffi.FFI()
-    ffibuilder.set_source(module_name, code_body, include_dirs=[ffcx.codegeneration.get_include_path()],
-                          extra_compile_args=cffi_extra_compile_args, libraries=cffi_libraries)
-    ffibuilder.cdef(decl)
 
+def _build_module(decl, code_body, module_name, cache_dir, cffi_extra_compile_args, cffi_verbose, cffi_debug,
+                  cffi_libraries, backend="cffi"):
+    """Compile generated code into a module and mark it as ready in the cache."""
     c_filename = cache_dir.joinpath(module_name + ".c")
     ready_name = c_filename.with_suffix(".c.cached")
 
@@ -265,10 +780,23 @@ def _compile_objects(decl, ufl_objects, object_names, module_name, options, cach
     logger.info(79 * "#")
 
     t0 = time.time()
-    f = io.StringIO()
-    with redirect_stdout(f):
-        ffibuilder.compile(tmpdir=cache_dir, verbose=True, debug=cffi_debug)
-    s = f.getvalue()
+    with ffcx.profiling.region("C compilation", "jit", module=module_name, backend=backend,
+                               extra_compile_args=cffi_extra_compile_args):
+        if backend == "cffi":
+            ffibuilder = cffi.FFI()
+            ffibuilder.set_source(module_name, code_body, include_dirs=[ffcx.codegeneration.get_include_path()],
+                                  extra_compile_args=cffi_extra_compile_args, libraries=cffi_libraries)
+            ffibuilder.cdef(decl)
+
+            f = io.StringIO()
+            with redirect_stdout(f):
+                ffibuilder.compile(tmpdir=cache_dir, verbose=True, debug=cffi_debug)
+            s = f.getvalue()
+        elif backend == "direct":
+            s = _compile_shared_library(code_body, module_name, cache_dir, cffi_extra_compile_args,
+                                        cffi_debug, cffi_libraries)
+        else:
+            raise ValueError(f"Unknown JIT backend '{backend}'.")
     if (cffi_verbose):
         print(s)
 
@@ -281,10 +809,159 @@ def _compile_objects(decl, ufl_objects, object_names, module_name, options, cach
     fd.write(s)
     fd.close()
 
-    return code_body
 
+def _compile_tiered(decl, ufl_objects, object_names, module_name, quick_module_name, options, cache_dir, timeout,
+                    cffi_extra_compile_args, cffi_verbose, cffi_debug, cffi_libraries, backend):
+    """Return the optimised module if it is ready, otherwise a quickly compiled one.
+
+    If nobody is building the optimised module yet, it is claimed
+    (through its exclusive C file) and built by a background process.
+    Meanwhile, the same code is compiled with ``TIERED_QUICK_COMPILE_ARGS``
+    appended and returned. Both modules share the object names of the
+    optimised module, so they can be used interchangeably, and the
+    optimised one is picked up from the cache once its ready file
+    exists.
+    """
+    cache_dir.mkdir(exist_ok=True, parents=True)
+    c_filename = cache_dir.joinpath(module_name + ".c")
+    if c_filename.with_suffix(".c.cached").exists():
+        obj, mod = _load_objects(cache_dir, module_name, object_names, decl, backend)
+        return obj, mod, (None, None)
+
+    code_body = None
+    try:
+        open(c_filename, "x")
+    except FileExistsError:
+        logger.info(f"Optimised module {module_name} is being compiled elsewhere.")
+    else:
+        try:
+            code_body = _generate_code(ufl_objects, module_name, options)
+            _start_background_build(decl, code_body, module_name, cache_dir, cffi_extra_compile_args,
+                                    cffi_debug, cffi_libraries, backend)
+        except Exception:
+            os.replace(c_filename, c_filename.with_suffix(".c.failed"))
+            raise
+
+    obj, mod = get_cached_module(quick_module_name, object_names, cache_dir, timeout, decl, backend)
+    if obj is not None:
+        return obj, mod, (None, None)
+
+    quick_compile_args = list(cffi_extra_compile_args or []) + TIERED_QUICK_COMPILE_ARGS
+    try:
+        if code_body is None:
+            code_body = _generate_code(ufl_objects, module_name, options)
+        _build_module(decl, code_body, quick_module_name, cache_dir, quick_compile_args, cffi_verbose, cffi_debug,
+                      cffi_libraries, backend)
+    except Exception:
+        quick_c_filename = cache_dir.joinpath(quick_module_name + ".c")
+        os.replace(quick_c_filename, quick_c_filename.with_suffix(".c.failed"))
+        raise
+
+    obj, mod = _load_objects(cache_dir, quick_module_name, object_names, decl, backend)
+    return obj, mod, (decl, code_body)
 
-def _load_objects(cache_dir, module_name, object_names):
+
+def _start_background_build(decl, code_body, module_name, cache_dir, cffi_extra_compile_args, cffi_debug,
+                            cffi_libraries, backend):
+    """Build a module in a detached Python process.
+
+    The inputs are passed through a JSON file in the cache directory.
+    The process runs in its own session so that it survives signals
+    sent to the foreground process group (e.g. Ctrl-C).
+    """
+    fd, args_filename = tempfile.mkstemp(suffix=".json", dir=cache_dir)
+    with os.fdopen(fd, "w") as f:
+        json.dump({"decl": decl, "code_body": code_body, "module_name": module_name,
+                   "cache_dir": str(cache_dir), "cffi_extra_compile_args": cffi_extra_compile_args,
+                   "cffi_debug": cffi_debug, "cffi_libraries": cffi_libraries, "backend": backend}, f)
+
+    cmd = [sys.executable, "-c", "import ffcx.codegeneration.jit as jit; jit._background_build()", args_filename]
+    proc = subprocess.Popen(cmd, stdin=subprocess.DEVNULL, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL,
+                            start_new_session=True)
+    _background_builds.append(proc)
+    logger.info(f"Started background build of {module_name} (pid {proc.pid}).")
+
+
+def _background_build():
+    """Entry point of the process started by ``_start_background_build``."""
+    args_filename = sys.argv[1]
+    with open(args_filename, "r") as f:
+        args = json.load(f)
+    os.remove(args_filename)
+
+    cache_dir = Path(args["cache_dir"])
+    try:
+        _build_module(args["decl"], args["code_body"], args["module_name"], cache_dir,
+                      args["cffi_extra_compile_args"], False, args["cffi_debug"], args["cffi_libraries"],
+                      args["backend"])
+    except Exception:
+        c_filename = cache_dir.joinpath(args["module_name"] + ".c")
+        os.replace(c_filename, c_filename.with_suffix(".c.failed"))
+        raise
+
+
+def wait_for_background_builds(timeout=None):
+    """Wait for the optimised builds started by tiered compilation of this process.
+
+    Returns the number of builds that failed.
+    """
+    failed = 0
+    while _background_builds:
+        proc = _background_builds.pop()
+        if proc.wait(timeout) != 0:
+            failed += 1
+    return failed
+
+
+def _compile_shared_library(code_body, module_name, cache_dir, extra_compile_args, debug, libraries):
+    """Compile generated code into a plain shared library with the C compiler.
+
+    Returns the compiler command and its output.
+    """
+    c_filename = cache_dir.joinpath(module_name + ".c")
+    lib_filename = cache_dir.joinpath(module_name + ".so")
+    with open(c_filename, "w") as f:
+        f.write(code_body)
+
+    return _link_shared_library([c_filename], lib_filename, extra_compile_args, debug, libraries)
+
+
+def _link_shared_library(c_filenames, lib_filename, extra_compile_args, debug, libraries):
+    """Compile and link C files into a shared library.
+
+    The library is written to a temporary file first and moved into
+    place once complete, so that it is never seen half-written.
+    Returns the compiler command and its output.
+    """
+    lib_filename = Path(lib_filename)
+    cc = shlex.split(os.environ.get("CC") or sysconfig.get_config_var("CC") or "cc")
+    flags = ["-O3", "-fPIC", "-shared"]
+    if debug:
+        flags += ["-g"]
+    flags += ["-I" + ffcx.codegeneration.get_include_path()]
+    flags += list(extra_compile_args or [])
+    libs = ["-l" + lib for lib in (libraries or [])]
+
+    fd, tmp_filename = tempfile.mkstemp(suffix=".so", dir=lib_filename.parent)
+    os.close(fd)
+    cmd = cc + flags + ["-o", tmp_filename] + [str(f) for f in c_filenames] + libs
+    command = " ".join(cmd)
+    try:
+        result = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, universal_newlines=True)
+        if result.returncode != 0:
+            raise RuntimeError(f"JIT C compiler failed:\n{command}\n{result.stdout}")
+        os.replace(tmp_filename, lib_filename)
+    finally:
+        if os.path.exists(tmp_filename):
+            os.remove(tmp_filename)
+
+    return command + "\n" + result.stdout
+
+
+def _load_objects(cache_dir, module_name, object_names, decl=None, backend="cffi"):
+
+    if backend == "direct":
+        return _load_shared_library_objects(cache_dir, module_name, object_names, decl)
 
     # Create module finder that searches the compile path
     finder = importlib.machinery.FileFinder(
@@ -307,3 +984,27 @@ def _load_objects(cache_dir, module_name, object_names):
         compiled_objects.append(obj)
 
     return compiled_objects, compiled_module
+
+
+def _load_shared_library_objects(cache_dir, module_name, object_names, decl):
+    """Open a shared library built by the direct backend.
+
+    The returned module mimics a CFFI extension module, i.e. it has
+    ``ffi`` and ``lib`` attributes, so that callers can use either
+    backend interchangeably.
+    """
+    lib_filename = Path(cache_dir).joinpath(module_name + ".so")
+    if not lib_filename.exists():
+        raise ModuleNotFoundError("Unable to find JIT module.")
+
+    ffi = cffi.FFI()
+    ffi.cdef(decl)
+    lib = ffi.dlopen(str(lib_filename))
+
+    compiled_module = types.ModuleType(module_name)
+    compiled_module.__file__ = str(lib_filename)
+    compiled_module.ffi = ffi
+    compiled_module.lib = lib
+
+    compiled_objects = [getattr(lib, name) for name in object_names]
+    return compiled_objects, compiled_module
@@ -0,0 +1,80 @@
+# Copyright (C) 2022 FEniCS Project
+#
+# This file is part of FFCx. (https://www.fenicsproject.org)
+#
+# SPDX-License-Identifier:    LGPL-3.0-or-later
+"""Machine-readable description of the kernels of a module.
+
+The manifest lists, for every integral and expression, the data an
+assembler or a performance model needs without parsing the generated
+C: quadrature rules, static tables, the element tensor shape, flops,
+scratch memory and an estimate of the bytes moved per call (see
+``ffcx.codegeneration.flop_count``).
+"""
+
+import numpy
+
+import ffcx.codegeneration.C.cnodes as L
+from ffcx import __version__ as FFCX_VERSION
+from ffcx.codegeneration.flop_count import count_memory_traffic
+from ffcx.codegeneration.integrals import scratch_bytes
+from ffcx.naming import c_type_size
+
+
+class Manifest(object):
+    """Manifest of a module, filled in by the code generators.
+
+    The integral and expression generators add an entry for each kernel
+    from the tabulate_tensor ast they build anyway, so the kernels are
+    generated only once.
+    """
+
+    def __init__(self, ir, options):
+        self.options = options
+        self.forms = [{"name": form_ir.name, "rank": form_ir.rank,
+                       "integrals": {itg_type: names for itg_type, names in form_ir.integral_names.items() if names}}
+                      for form_ir in ir.forms]
+        self.integrals = []
+        self.expressions = []
+
+    def add_integral(self, ir, ast, flops, num_scratch_bytes):
+        """Add the kernel of an integral, whose flops and scratch memory the generator has counted."""
+        subdomain_id = list(ir.subdomain_id) if isinstance(ir.subdomain_id, tuple) else ir.subdomain_id
+        entry = {"name": ir.name, "integral_type": ir.integral_type, "subdomain_id": subdomain_id,
+                 "enabled_coefficients": [bool(e) for e in ir.enabled_coefficients],
+                 "needs_facet_permutations": ir.needs_facet_permutations}
+        entry.update(self._kernel_entry(ir, ast, flops, num_scratch_bytes))
+        self.integrals.append(entry)
+
+    def add_expression(self, ir, ast):
+        """Add the kernel of an expression."""
+        entry = {"name": ir.name, "name_from_uflfile": ir.name_from_uflfile,
+                 "expression_shape": [int(n) for n in ir.expression_shape], "num_points": int(ir.points.shape[0]),
+                 "needs_facet_permutations": ir.needs_facet_permutations}
+        entry.update(self._kernel_entry(ir, ast, ast.flops(), scratch_bytes(ast)))
+        self.expressions.append(entry)
+
+    def to_dict(self) -> dict:
+        """Return the manifest as a JSON-serialisable dictionary."""
+        return {"ffcx_version": FFCX_VERSION, "scalar_type": self.options["scalar_type"], "forms": self.forms,
+                "integrals": self.integrals, "expressions": self.expressions}
+
+    def _kernel_entry(self, ir, ast, flops, num_scratch_bytes):
+        """Describe the kernel of an integral or expression from its IR and tabulate_tensor ast."""
+        tables = []
+        for node in L.iter_nodes(ast):
+            if isinstance(node, L.ArrayDecl) and "static" in node.typename.split():
+                shape = [int(n) for n in L.pad_innermost_dim(node.sizes, node.padlen)]
+                tables.append({"name": node.symbol.name, "shape": shape,
+                               "type": node.typename.replace("static", "").replace("const", "").strip(),
+                               "bytes": int(numpy.prod(shape)) * c_type_size(node.typename)})
+
+        return {
+            "rank": len(ir.tensor_shape),
+            "tensor_shape": [int(n) for n in ir.tensor_shape],
+            "quadrature_rules": [{"id": rule.id(), "num_points": len(rule.weights)} for rule in ir.integrand],
+            "tables": tables,
+            "flops": flops,
+            "scratch_bytes": num_scratch_bytes,
+            "bytes_moved": count_memory_traffic(ast, self.options),
+        }
@@ -94,6 +94,18 @@ class FFCXBackendSymbols(object):
         indices = ["i", "j", "k", "l"]
         return self.S(indices[iarg])
 
+    def action_vectors(self):
+        """Symbol for the vectors a bilinear form is applied to by tabulate_action."""
+        return self.S("u")
+
+    def num_action_vectors(self):
+        """Symbol for the number of vectors a bilinear form is applied to."""
+        return self.S("num_vectors")
+
+    def action_vector_index(self):
+        """Loop index for the vectors a bilinear form is applied to."""
+        return self.S("iv")
+
     def coefficient_dof_sum_index(self):
         """Index for loops over coefficient dofs, assumed to never be used in two nested loops."""
         return self.S("ic")
@@ -316,6 +316,164 @@ extern "C"
       const int* restrict entity_local_index,
       const uint8_t* restrict quadrature_permutation);
 
+  /// Integrate a functional (rank 0 integral) over a batch of entities
+  /// with single precision and add the sum to result
+  ///
+  /// The arguments are those of ufcx_tabulate_tensor_float32 for each
+  /// entity, stored one after another.
+  ///
+  /// @param[in,out] result The sum over the entities is added to
+  /// *result. Threads can reduce disjoint batches into their own
+  /// partial results.
+  /// @param[in] num_entities Number of entities in the batch
+  /// @param[in] w Coefficients of each entity. Dimensions:
+  /// w[num_entities][num_coefficient_values]
+  /// @param[in] c Constants, shared by all entities
+  /// @param[in] coordinate_dofs Coordinate dofs of each entity.
+  /// Dimensions: coordinate_dofs[num_entities][restriction][num_coordinate_dofs][3]
+  /// @param[in] entity_local_index Local index of each entity.
+  /// Dimensions: entity_local_index[num_entities][restriction] for
+  /// facet integrals, entity_local_index[num_entities] for vertex
+  /// integrals, unused for cell integrals
+  /// @param[in] quadrature_permutation Facet permutations of each
+  /// entity. Dimensions: quadrature_permutation[num_entities][2] for
+  /// interior facet integrals, unused otherwise
+  ///
+  /// @see ufcx_tabulate_tensor_float32
+  typedef void(ufcx_tabulate_functional_float32)(
+      float* restrict result, int64_t num_entities,
+      const float* restrict w, const float* restrict c,
+      const float* restrict coordinate_dofs,
+      const int* restrict entity_local_index,
+      const uint8_t* restrict quadrature_permutation);
+
+  /// Integrate a functional over a batch of entities with double
+  /// precision
+  ///
+  /// @see ufcx_tabulate_functional_float32
+  typedef void(ufcx_tabulate_functional_float64)(
+      double* restrict result, int64_t num_entities,
+      const double* restrict w, const double* restrict c,
+      const double* restrict coordinate_dofs,
+      const int* restrict entity_local_index,
+      const uint8_t* restrict quadrature_permutation);
+
+  /// Integrate a functional over a batch of entities with extended
+  /// double precision
+  ///
+  /// @see ufcx_tabulate_functional_float32
+  typedef void(ufcx_tabulate_functional_longdouble)(
+      long double* restrict result, int64_t num_entities,
+      const long double* restrict w, const long double* restrict c,
+      const long double* restrict coordinate_dofs,
+      const int* restrict entity_local_index,
+      const uint8_t* restrict quadrature_permutation);
+
+  /// Integrate a functional over a batch of entities with complex
+  /// single precision
+  ///
+  /// @see ufcx_tabulate_functional_float32
+  typedef void(ufcx_tabulate_functional_complex64)(
+      float _Complex* restrict result, int64_t num_entities,
+      const float _Complex* restrict w, const float _Complex* restrict c,
+      const float* restrict coordinate_dofs,
+      const int* restrict entity_local_index,
+      const uint8_t* restrict quadrature_permutation);
+
+  /// Integrate a functional over a batch of entities with complex
+  /// double precision
+  ///
+  /// @see ufcx_tabulate_functional_float32
+  typedef void(ufcx_tabulate_functional_complex128)(
+      double _Complex* restrict result, int64_t num_entities,
+      const double _Complex* restrict w, const double _Complex* restrict c,
+      const double* restrict coordinate_dofs,
+      const int* restrict entity_local_index,
+      const uint8_t* restrict quadrature_permutation);
+
+  /// Apply the element matrix of a bilinear integral to several
+  /// vectors with single precision, without forming the matrix
+  ///
+  /// For each vector u_k, A_k += A_e u_k, where A_e is the tensor
+  /// computed by ufcx_tabulate_tensor_float32. The geometry,
+  /// coefficients and tables are evaluated once for all vectors.
+  ///
+  /// @param[in,out] A Products, to which the results are added.
+  /// Dimensions: A[num_vectors][tensor_shape[0]]
+  /// @param[in] num_vectors Number of vectors
+  /// @param[in] u Vectors. Dimensions: u[num_vectors][tensor_shape[1]]
+  ///
+  /// The remaining arguments are those of
+  /// ufcx_tabulate_tensor_float32.
+  ///
+  /// @see ufcx_tabulate_tensor_float32
+  typedef void(ufcx_tabulate_action_float32)(
+      float* restrict A, int num_vectors, const float* restrict u,
+      const float* restrict w, const float* restrict c,
+      const float* restrict coordinate_dofs,
+      const int* restrict entity_local_index,
+      const uint8_t* restrict quadrature_permutation);
+
+  /// Apply the element matrix of a bilinear integral to several
+  /// vectors with double precision
+  ///
+  /// @see ufcx_tabulate_action_float32
+  typedef void(ufcx_tabulate_action_float64)(
+      double* restrict A, int num_vectors, const double* restrict u,
+      const double* restrict w, const double* restrict c,
+      const double* restrict coordinate_dofs,
+      const int* restrict entity_local_index,
+      const uint8_t* restrict quadrature_permutation);
+
+  /// Apply the element matrix of a bilinear integral to several
+  /// vectors with extended double precision
+  ///
+  /// @see ufcx_tabulate_action_float32
+  typedef void(ufcx_tabulate_action_longdouble)(
+      long double* restrict A, int num_vectors,
+      const long double* restrict u, const long double* restrict w,
+      const long double* restrict c,
+      const long double* restrict coordinate_dofs,
+      const int* restrict entity_local_index,
+      const uint8_t* restrict quadrature_permutation);
+
+  /// Apply the element matrix of a bilinear integral to several
+  /// vectors with complex single precision
+  ///
+  /// @see ufcx_tabulate_action_float32
+  typedef void(ufcx_tabulate_action_complex64)(
+      float _Complex* restrict A, int num_vectors,
+      const float _Complex* restrict u, const float _Complex* restrict w,
+      const float _Complex* restrict c,
+      const float* restrict coordinate_dofs,
+      const int* restrict entity_local_index,
+      const uint8_t* restrict quadrature_permutation);
+
+  /// Apply the element matrix of a bilinear integral to several
+  /// vectors with complex double precision
+  ///
+  /// @see ufcx_tabulate_action_float32
+  typedef void(ufcx_tabulate_action_complex128)(
+      double _Complex* restrict A, int num_vectors,
+      const double _Complex* restrict u, const double _Complex* restrict w,
+      const double _Complex* restrict c,
+      const double* restrict coordinate_dofs,
+      const int* restrict entity_local_index,
+      const uint8_t* restrict quadrature_permutation);
+
+  /// Call statistics of an integral, collected by tabulate_tensor when
+  /// the code is generated with the option instrument_kernels. The
+  /// counters are updated atomically and can be read or reset by the
+  /// caller at any time.
+  typedef struct ufcx_integral_statistics
+  {
+    /// Number of calls of tabulate_tensor
+    uint64_t num_calls;
+
+    /// Total wall-clock time spent in tabulate_tensor, in nanoseconds
+    uint64_t time_ns;
+  } ufcx_integral_statistics;
+
   typedef struct ufcx_integral
   {
     const bool* enabled_coefficients;
@@ -328,6 +486,58 @@ extern "C"
 
     /// Get the coordinate element associated with the geometry of the mesh.
     ufcx_finite_element* coordinate_element;
+
+    /// Call statistics of tabulate_tensor, or NULL if the code was
+    /// generated without instrumentation.
+    ufcx_integral_statistics* statistics;
+
+    /// Rank of the element tensor A (number of arguments)
+    int rank;
+
+    /// Shape of the element tensor A (rank entries, NULL if the rank
+    /// is zero). For interior facet integrals this includes the dofs
+    /// of both cells.
+    int* tensor_shape;
+
+    /// Length of the packed coefficient array w
+    int num_coefficient_values;
+
+    /// Length of the packed constant array c
+    int num_constant_values;
+
+    /// Number of dofs (points) of the coordinate element of one cell,
+    /// i.e. coordinate_dofs has 3 * num_coordinate_dofs entries per
+    /// cell
+    int num_coordinate_dofs;
+
+    /// Estimated number of floating point operations of one call of
+    /// tabulate_tensor
+    int64_t flops;
+
+    /// Size in bytes of the arrays tabulate_tensor declares on the
+    /// stack
+    int64_t scratch_bytes;
+
+    /// Batched integration of a functional, for rank 0 integrals
+    /// generated with the option tabulate_functional (NULL otherwise).
+    /// The sum is accumulated in several independent scalar partial
+    /// sums, with compensated (Kahan) summation if the code was
+    /// generated with the option functional_compensated_summation.
+    ufcx_tabulate_functional_float32* tabulate_functional_float32;
+    ufcx_tabulate_functional_float64* tabulate_functional_float64;
+    ufcx_tabulate_functional_longdouble* tabulate_functional_longdouble;
+    ufcx_tabulate_functional_complex64* tabulate_functional_complex64;
+    ufcx_tabulate_functional_complex128* tabulate_functional_complex128;
+
+    /// Matrix-free action of the element matrix on several vectors,
+    /// for rank 2 integrals generated with the option tabulate_action
+    /// (NULL otherwise). flops and scratch_bytes do not describe these
+    /// kernels.
+    ufcx_tabulate_action_float32* tabulate_action_float32;
+    ufcx_tabulate_action_float64* tabulate_action_float64;
+    ufcx_tabulate_action_longdouble* tabulate_action_longdouble;
+    ufcx_tabulate_action_complex64* tabulate_action_complex64;
+    ufcx_tabulate_action_complex128* tabulate_action_complex128;
   } ufcx_integral;
 
   typedef struct ufcx_expression
@@ -67,9 +67,11 @@ import logging
 import typing
 from time import time
 
+from ffcx import profiling
 from ffcx.analysis import analyze_ufl_objects
-from ffcx.codegeneration.codegeneration import generate_code
-from ffcx.formatting import format_code
+from ffcx.codegeneration.codegeneration import generate_code, generate_code_blocks
+from ffcx.codegeneration.manifest import Manifest
+from ffcx.formatting import format_code, write_code_blocks, write_manifest
 from ffcx.ir.representation import compute_ir
 
 logger = logging.getLogger("ffcx")
@@ -94,22 +96,71 @@ def compile_ufl_objects(ufl_objects: typing.List[typing.Any],
     """
     # Stage 1: analysis
     cpu_time = time()
-    analysis = analyze_ufl_objects(ufl_objects, options)
+    with profiling.region("analysis", "stage", prefix=prefix):
+        analysis = analyze_ufl_objects(ufl_objects, options)
     _print_timing(1, time() - cpu_time)
 
     # Stage 2: intermediate representation
     cpu_time = time()
-    ir = compute_ir(analysis, object_names, prefix, options, visualise)
+    with profiling.region("intermediate representation", "stage", prefix=prefix):
+        ir = compute_ir(analysis, object_names, prefix, options, visualise)
     _print_timing(2, time() - cpu_time)
 
     # Stage 3: code generation
     cpu_time = time()
-    code = generate_code(ir, options)
+    with profiling.region("code generation", "stage", prefix=prefix):
+        code = generate_code(ir, options)
     _print_timing(3, time() - cpu_time)
 
     # Stage 4: format code
     cpu_time = time()
-    code_h, code_c = format_code(code, options)
+    with profiling.region("formatting", "stage", prefix=prefix):
+        code_h, code_c = format_code(code, options)
     _print_timing(4, time() - cpu_time)
 
     return code_h, code_c
+
+
+def write_ufl_objects(ufl_objects: typing.List[typing.Any],
+                      output_dir: str,
+                      object_names: typing.Dict = {},
+                      prefix: str = None,
+                      options: typing.Dict = {},
+                      visualise: bool = False,
+                      manifest: bool = False):
+    """Generate UFC code for given UFL objects and write it to file.
+
+    Produces the same files as compile_ufl_objects followed by
+    formatting.write_code, but code generation and formatting are
+    interleaved: the code for each object is written to
+    ``output_dir/prefix.{h,c}`` as soon as it is generated, and its IR
+    and code are released before the next object. This keeps the peak
+    memory close to that of the largest single kernel.
+
+    If manifest is True, a JSON description of the kernels (see
+    ffcx.codegeneration.manifest) is also written to ``prefix.json``.
+
+    """
+    # Stage 1: analysis
+    cpu_time = time()
+    with profiling.region("analysis", "stage", prefix=prefix):
+        analysis = analyze_ufl_objects(ufl_objects, options)
+    _print_timing(1, time() - cpu_time)
+
+    # Stage 2: intermediate representation
+    cpu_time = time()
+    with profiling.region("intermediate representation", "stage", prefix=prefix):
+        ir = compute_ir(analysis, object_names, prefix, options, visualise)
+    _print_timing(2, time() - cpu_time)
+
+    # The manifest is filled in by code generation, which consumes the
+    # IR
+    kernels = Manifest(ir, options) if manifest else None
+
+    # Stages 3 and 4: code generation and formatting
+    cpu_time = time()
+    with profiling.region("code generation and formatting", "stage", prefix=prefix):
+        write_code_blocks(generate_code_blocks(ir, options, kernels), options, prefix, output_dir)
+    if kernels is not None:
+        write_manifest(kernels.to_dict(), prefix, output_dir)
+    logger.info(f"Compiler stages 3 and 4 finished in {time() - cpu_time:.4f} seconds.")
@@ -13,6 +13,8 @@ ufcx_utils.
 
 """
 
+import filecmp
+import json
 import logging
 import os
 import pprint
@@ -64,21 +66,7 @@ def format_code(code, options: dict):
     logger.info("Compiler stage 5: Formatting code")
     logger.info(79 * "*")
 
-    # Generate code for comment at top of file
-    code_h_pre = _generate_comment(options) + "\n"
-    code_c_pre = _generate_comment(options) + "\n"
-
-    # Generate code for header
-    code_h_pre += FORMAT_TEMPLATE["header_h"]
-    code_c_pre += FORMAT_TEMPLATE["header_c"]
-
-    # Generate includes and add to preamble
-    includes_h, includes_c = _generate_includes(options)
-    code_h_pre += includes_h
-    code_c_pre += includes_c
-
-    # Enclose header with 'extern "C"'
-    code_h_pre += c_extern_pre
+    code_h_pre, code_c_pre = _generate_preamble(options)
     code_h_post = c_extern_post
 
     code_h = ""
@@ -100,11 +88,96 @@ def write_code(code_h, code_c, prefix, output_dir):
     _write_file(code_c, prefix, ".c", output_dir)
 
 
+def write_code_blocks(blocks, options: dict, prefix, output_dir):
+    """Format and write code blocks to file as they are produced.
+
+    Each (declaration, implementation) block is written as soon as it is
+    taken from ``blocks``, so at most one block is held in memory. The
+    files are written under temporary names and only moved into place
+    once all blocks have been written, and only if their content changed.
+
+    """
+    logger.info(79 * "*")
+    logger.info("Compiler stage 5: Formatting code")
+    logger.info(79 * "*")
+
+    filename_h = os.path.join(output_dir, prefix + ".h")
+    filename_c = os.path.join(output_dir, prefix + ".c")
+    code_h_pre, code_c_pre = _generate_preamble(options)
+    try:
+        with open(filename_h + ".part", "w") as hfile, open(filename_c + ".part", "w") as cfile:
+            hfile.write(code_h_pre)
+            cfile.write(code_c_pre)
+            for code_h, code_c in blocks:
+                hfile.write(code_h)
+                cfile.write(code_c)
+            hfile.write(c_extern_post)
+    except BaseException:
+        for filename in (filename_h, filename_c):
+            if os.path.exists(filename + ".part"):
+                os.remove(filename + ".part")
+        raise
+
+    _replace_if_changed(filename_h + ".part", filename_h)
+    _replace_if_changed(filename_c + ".part", filename_c)
+
+
+def write_depfile(targets, dependencies, prefix, output_dir):
+    """Write a make-style dependency file ``prefix.d`` listing the files the targets depend on."""
+    def escape(path):
+        return str(path).replace(" ", "\\ ").replace("#", "\\#").replace("$", "$$")
+
+    output = " ".join(escape(t) for t in targets) + ":"
+    output += "".join(f" \\\n  {escape(d)}" for d in dependencies) + "\n"
+    _write_file(output, prefix, ".d", output_dir)
+
+
+def write_manifest(manifest, prefix, output_dir):
+    """Write the kernel manifest of a module to ``prefix.json``."""
+    _write_file(json.dumps(manifest, indent=2) + "\n", prefix, ".json", output_dir)
+
+
 def _write_file(output, prefix, postfix, output_dir):
-    """Write generated code to file."""
+    """Write generated code to file, unless the file already has this content."""
     filename = os.path.join(output_dir, prefix + postfix)
-    with open(filename, "w") as hfile:
+    with open(filename + ".part", "w") as hfile:
         hfile.write(output)
+    _replace_if_changed(filename + ".part", filename)
+
+
+def _replace_if_changed(tmp_filename, filename):
+    """Move a file into place if its content differs from the existing file.
+
+    Unchanged files are left untouched, so that their modification time
+    does not trigger rebuilds of code that depends on them.
+
+    """
+    if os.path.isfile(filename) and filecmp.cmp(tmp_filename, filename, shallow=False):
+        logger.info(f"{filename} is up to date")
+        os.remove(tmp_filename)
+    else:
+        os.replace(tmp_filename, filename)
+
+
+def _generate_preamble(options):
+    """Generate code at the top of the header and source files."""
+    # Generate code for comment at top of file
+    code_h_pre = _generate_comment(options) + "\n"
+    code_c_pre = _generate_comment(options) + "\n"
+
+    # Generate code for header
+    code_h_pre += FORMAT_TEMPLATE["header_h"]
+    code_c_pre += FORMAT_TEMPLATE["header_c"]
+
+    # Generate includes and add to preamble
+    includes_h, includes_c = _generate_includes(options)
+    code_h_pre += includes_h
+    code_c_pre += includes_c
+
+    # Enclose header with 'extern "C"'
+    code_h_pre += c_extern_pre
+
+    return code_h_pre, code_c_pre
 
 
 def _generate_comment(options):
@@ -139,10 +212,17 @@ def _generate_includes(options: dict):
     if "_Complex" in options["scalar_type"]:
         default_c_includes += ["#include <complex.h>"]
 
+    if options["instrument_kernels"]:
+        default_c_includes += ["#include <time.h>"]
+
     s_h = set(default_h_includes)
     s_c = set(default_c_includes)
 
     includes_h = "\n".join(sorted(s_h)) + "\n" if s_h else ""
     includes_c = "\n".join(sorted(s_c)) + "\n" if s_c else ""
 
+    # clock_gettime is POSIX, not ISO C
+    if options["instrument_kernels"]:
+        includes_c = "#ifndef _POSIX_C_SOURCE\n#define _POSIX_C_SOURCE 199309L\n#endif\n" + includes_c
+
     return includes_h, includes_c
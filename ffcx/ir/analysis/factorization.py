@@ -6,6 +6,7 @@
 """Algorithms for factorizing argument dependent monomials."""
 
 import logging
+import operator
 from functools import singledispatch
 
 from ffcx.ir.analysis.graph import ExpressionGraph
@@ -21,8 +22,8 @@ logger = logging.getLogger("ffcx")
 def build_argument_indices(S):
     """Build ordered list of indices to modified arguments."""
     arg_indices = []
-    for i, v in S.nodes.items():
-        arg = strip_modified_terminal(v['expression'])
+    for i, v in enumerate(S.expressions):
+        arg = strip_modified_terminal(v)
         if isinstance(arg, Argument):
             arg_indices.append(i)
 
@@ -32,7 +33,7 @@ def build_argument_indices(S):
 
         Key is based on the properties of the modified terminal.
         """
-        mt = analyse_modified_terminal(S.nodes[i]['expression'])
+        mt = analyse_modified_terminal(S.expressions[i])
         return mt.argument_ordering_key()
 
     ordered_arg_indices = sorted(arg_indices, key=arg_ordering_key)
@@ -43,12 +44,54 @@ def graph_insert(F, expr):
     """Add new expression expr to factorisation graph or return existing index."""
     fi = F.e2i.get(expr)
     if fi is None:
-        fi = F.number_of_nodes()
-        F.add_node(fi, expression=expr)
+        fi = F.add_node(expr)
         F.e2i[expr] = fi
     return fi
 
 
+def graph_insert_operation(F, op, fi0, fi1):
+    """Insert op(f0, f1) for the nodes fi0 and fi1 into the factorisation graph.
+
+    Results are memoised on (op, fi0, fi1), which avoids building and
+    hashing the same UFL expression repeatedly.
+    """
+    key = (op, fi0, fi1)
+    fi = F.operations.get(key)
+    if fi is None:
+        fi = graph_insert(F, op(F.expressions[fi0], F.expressions[fi1]))
+        F.operations[key] = fi
+    return fi
+
+
+def monomial(F, argkey):
+    """Return the id of the monomial with the sorted tuple argkey of argument indices.
+
+    Monomials are interned in F.monomials, so that the factors of a
+    subexpression are keyed on plain integers rather than on tuples that
+    are hashed and compared at every lookup.
+    """
+    m = F.monomial_ids.get(argkey)
+    if m is None:
+        m = len(F.monomials)
+        F.monomials.append(argkey)
+        F.monomial_ids[argkey] = m
+    return m
+
+
+def monomial_product(F, m0, m1):
+    """Return the id of the product of the monomials m0 and m1, memoised on (m0, m1)."""
+    m = F.monomial_products.get((m0, m1))
+    if m is None:
+        m = monomial(F, tuple(sorted(F.monomials[m0] + F.monomials[m1])))
+        F.monomial_products[(m0, m1)] = m
+    return m
+
+
+def sorted_monomials(F, monomials):
+    """Sort monomial ids by their argument indices, the canonical order of the factors."""
+    return sorted(monomials, key=F.monomials.__getitem__)
+
+
 # Reuse these empty objects where appropriate to save memory
 noargs = {}  # type: ignore
 
@@ -74,11 +117,11 @@ def handle_sum(v, fac, sf, F):
     argkeys = set(fac0) | set(fac1)
 
     if argkeys:  # f*arg + g*arg = (f+g)*arg
-        argkeys = sorted(argkeys)
-        keylen = len(argkeys[0])
+        argkeys = sorted_monomials(F, argkeys)
+        keylen = len(F.monomials[argkeys[0]])
         factors = {}
         for argkey in argkeys:
-            if len(argkey) != keylen:
+            if len(F.monomials[argkey]) != keylen:
                 raise RuntimeError("Expecting equal argument rank terms among summands.")
 
             fi0 = fac0.get(argkey)
@@ -88,9 +131,7 @@ def handle_sum(v, fac, sf, F):
             elif fi1 is None:
                 fisum = fi0
             else:
-                f0 = F.nodes[fi0]['expression']
-                f1 = F.nodes[fi1]['expression']
-                fisum = graph_insert(F, f0 + f1)
+                fisum = graph_insert_operation(F, operator.add, fi0, fi1)
             factors[argkey] = fisum
 
     else:  # non-arg + non-arg
@@ -111,29 +152,24 @@ def handle_product(v, fac, sf, F):
 
     elif not fac0:  # non-arg * arg
         # Record products of non-arg operand with each factor of arg-dependent operand
-        f0 = sf[0]
         factors = {}
-        for k1 in sorted(fac1):
-            f1 = F.nodes[fac1[k1]]['expression']
-            factors[k1] = graph_insert(F, f0 * f1)
+        for k1 in sorted_monomials(F, fac1):
+            factors[k1] = graph_insert_operation(F, operator.mul, sf[0], fac1[k1])
 
     elif not fac1:  # arg * non-arg
         # Record products of non-arg operand with each factor of arg-dependent operand
-        f1 = sf[1]
         factors = {}
-        for k0 in sorted(fac0):
-            f0 = F.nodes[fac0[k0]]['expression']
-            factors[k0] = graph_insert(F, f1 * f0)
+        for k0 in sorted_monomials(F, fac0):
+            factors[k0] = graph_insert_operation(F, operator.mul, sf[1], fac0[k0])
 
     else:  # arg * arg
         # Record products of each factor of arg-dependent operand
         factors = {}
-        for k0 in sorted(fac0):
-            f0 = F.nodes[fac0[k0]]['expression']
-            for k1 in sorted(fac1):
-                f1 = F.nodes[fac1[k1]]['expression']
-                argkey = tuple(sorted(k0 + k1))  # sort key for canonical representation
-                factors[argkey] = graph_insert(F, f0 * f1)
+        keys1 = sorted_monomials(F, fac1)
+        for k0 in sorted_monomials(F, fac0):
+            for k1 in keys1:
+                argkey = monomial_product(F, k0, k1)
+                factors[argkey] = graph_insert_operation(F, operator.mul, fac0[k0], fac1[k1])
 
     return factors
 
@@ -145,7 +181,7 @@ def handle_conj(v, fac, sf, F):
     if fac:
         factors = {}
         for k in fac:
-            f0 = F.nodes[fac[k]]['expression']
+            f0 = F.expressions[fac[k]]
             factors[k] = graph_insert(F, Conj(f0))
     else:
         raise RuntimeError("No arguments")
@@ -161,11 +197,9 @@ def handle_division(v, fac, sf, F):
 
     if fac0:  # arg / non-arg
         # Record products of non-arg operand with each factor of arg-dependent operand
-        f1 = sf[1]
         factors = {}
-        for k0 in sorted(fac0):
-            f0 = F.nodes[fac0[k0]]['expression']
-            factors[k0] = graph_insert(F, f0 / f1)
+        for k0 in sorted_monomials(F, fac0):
+            factors[k0] = graph_insert_operation(F, operator.truediv, fac0[k0], sf[1])
 
     else:  # non-arg / non-arg
         raise RuntimeError("No arguments")
@@ -183,27 +217,27 @@ def handle_conditional(v, fac, sf, F):
     if not (fac1 or fac2):  # non-arg ? non-arg : non-arg
         raise RuntimeError("No arguments")
     else:
-        f0 = sf[0]
-        f1 = sf[1]
-        f2 = sf[2]
+        f0 = None if sf[0] is None else F.expressions[sf[0]]
+        f1 = None if sf[1] is None else F.expressions[sf[1]]
+        f2 = None if sf[2] is None else F.expressions[sf[2]]
 
         # Term conditional(c, argument, non-argument) is not legal unless non-argument is 0.0
         assert fac1 or isinstance(f1, Zero)
         assert fac2 or isinstance(f2, Zero)
-        assert () not in fac1
-        assert () not in fac2
+        assert all(F.monomials[k] for k in fac1)
+        assert all(F.monomials[k] for k in fac2)
 
         z = as_ufl(0.0)
 
         # In general, can decompose like this:
         #    conditional(c, sum_i fi*ui, sum_j fj*uj) -> sum_i conditional(c, fi, 0)*ui + sum_j conditional(c, 0, fj)*uj
-        mas = sorted(set(fac1.keys()) | set(fac2.keys()))
+        mas = sorted_monomials(F, set(fac1.keys()) | set(fac2.keys()))
         factors = {}
         for k in mas:
             fi1 = fac1.get(k)
             fi2 = fac2.get(k)
-            f1 = z if fi1 is None else F.nodes[fi1]['expression']
-            f2 = z if fi2 is None else F.nodes[fi2]['expression']
+            f1 = z if fi1 is None else F.expressions[fi1]
+            f2 = z if fi2 is None else F.expressions[fi2]
             factors[k] = graph_insert(F, conditional(f0, f1, f2))
 
     return factors
@@ -242,12 +276,16 @@ def compute_argument_factorization(S, rank):
     """
     # Extract argument component subgraph
     arg_indices = build_argument_indices(S)
-    AV = [S.nodes[i]['expression'] for i in arg_indices]
+    AV = [S.expressions[i] for i in arg_indices]
 
     # Data structure for building non-argument factors
     F = ExpressionGraph()
-    # Attach a quick lookup dict for expression to index
-    F.e2i = {}
+    # Attach a memo of operations on factors, see graph_insert_operation,
+    # and the interned monomials, see monomial
+    F.operations = {}
+    F.monomials = []
+    F.monomial_ids = {}
+    F.monomial_products = {}
 
     # Insert arguments as first entries in factorisation graph
     # They will not be connected to other nodes, but will be available
@@ -263,53 +301,62 @@ def compute_argument_factorization(S, rank):
     # SV_factors[si] = None # if SV[si] does not depend on arguments
     # SV_factors[si] = { argkey: fi } # if SV[si] does depend on arguments, where:
     #   FV[fi] is the expression SV[si] with arguments factored out
-    #   argkey is a tuple with indices into SV for each of the argument components SV[si] depends on
+    #   argkey is the id of a monomial in F.monomials, a sorted tuple with indices into SV for each of the
+    #   argument components SV[si] depends on
     # SV_factors[si] = { argkey1: fi1, argkey2: fi2, ... } # if SV[si]
     # is a linear combination of multiple argkey configurations
 
+    S_factors = []
+    # Index in F of each subexpression in S without arg factors
+    S_findex = []
+    arg_positions = {si: k for k, si in enumerate(arg_indices)}
+
     # Factorize each subexpression in order:
-    for si, attr in S.nodes.items():
-        deps = S.out_edges[si]
-        v = attr['expression']
+    for si, v in enumerate(S.expressions):
+        deps = S.out_edges(si)
+        findex = None
 
-        if si in arg_indices:
+        if si in arg_positions:
             assert len(deps) == 0
             # v is a modified Argument
-            factors = {(si, ): one_index}
+            factors = {monomial(F, (si, )): one_index}
         else:
-            fac = [S.nodes[d]['factors'] for d in deps]
+            fac = [S_factors[d] for d in deps]
             if not any(fac):
                 # Entirely scalar (i.e. no arg factors)
                 # Just add unchanged to F
-                graph_insert(F, v)
+                findex = graph_insert(F, v)
                 factors = noargs
             else:
-                # Get scalar factors for dependencies
+                # Get indices in F of scalar factors for dependencies
                 # which do not have arg factors
                 sf = []
                 for i, d in enumerate(deps):
                     if fac[i]:
                         sf.append(None)
                     else:
-                        sf.append(S.nodes[d]['expression'])
+                        sf.append(S_findex[d])
                 # Use appropriate handler to deal with Sum, Product, etc.
                 factors = handler(v, fac, sf, F)
 
-        attr['factors'] = factors
+        S_factors.append(factors)
+        S_findex.append(findex)
 
-    assert len(F.nodes) == len(F.e2i)
+    assert F.number_of_nodes() == len(F.e2i)
+    monomials = F.monomials
+    del F.operations, F.monomials, F.monomial_ids, F.monomial_products
 
     # Prepare a mapping from component of expression to factors
     factors = {}
-    S_targets = [i for i, v in S.nodes.items() if v.get('target', False)]
+    S_targets = sorted(S.target)
 
     for S_target in S_targets:
         # Get the factorizations of the target values
-        if S.nodes[S_target]['factors'] == {}:
+        if S_factors[S_target] == {}:
             if rank == 0:
                 # Functionals and expressions: store as no args * factor
-                for comp in S.nodes[S_target]["component"]:
-                    factors[comp] = {(): F.e2i[S.nodes[S_target]['expression']]}
+                for comp in S.component[S_target]:
+                    factors[comp] = {(): F.e2i[S.expressions[S_target]]}
             else:
                 # Zero form of arity 1 or higher: make factors empty
                 pass
@@ -317,9 +364,9 @@ def compute_argument_factorization(S, rank):
             # Forms of arity 1 or higher:
             # Map argkeys from indices into SV to indices into AV,
             # and resort keys for canonical representation
-            for argkey, fi in S.nodes[S_target]['factors'].items():
-                ai_fi = {tuple(sorted(arg_indices.index(si) for si in argkey)): fi}
-                for comp in S.nodes[S_target]["component"]:
+            for m, fi in S_factors[S_target].items():
+                ai_fi = {tuple(sorted(arg_positions[si] for si in monomials[m])): fi}
+                for comp in S.component[S_target]:
                     if factors.get(comp):
                         factors[comp].update(ai_fi)
                     else:
@@ -328,15 +375,11 @@ def compute_argument_factorization(S, rank):
     # Indices into F that are needed for final result
     for comp, target in factors.items():
         for argkey, fi in target.items():
-            F.nodes[fi]["target"] = F.nodes[fi].get("target", [])
-            F.nodes[fi]["target"].append(argkey)
-
-            F.nodes[fi]["component"] = F.nodes[fi].get("component", [])
-            F.nodes[fi]["component"].append(comp)
+            F.target.setdefault(fi, []).append(argkey)
+            F.component.setdefault(fi, []).append(comp)
 
     # Compute dependencies in FV
-    for i, v in F.nodes.items():
-        expr = v['expression']
+    for i, expr in enumerate(F.expressions):
         if not expr._ufl_is_terminal_ and not expr._ufl_is_terminal_modifier_:
             for o in expr.ufl_operands:
                 F.add_edge(i, F.e2i[o])
@@ -5,6 +5,7 @@
 # SPDX-License-Identifier:    LGPL-3.0-or-later
 """Linearized data structure for the computational graph."""
 
+import array
 import logging
 
 import numpy
@@ -16,37 +17,96 @@ from ffcx.ir.analysis.valuenumbering import ValueNumberer
 
 logger = logging.getLogger("ffcx")
 
+# Node status codes, see ffcx.ir.integral.analyse_dependencies
+INACTIVE = 0
+ACTIVE = 1
+PIECEWISE = 2
+VARYING = 3
+status_codes = {"inactive": INACTIVE, "active": ACTIVE, "piecewise": PIECEWISE, "varying": VARYING}
+
 
 class ExpressionGraph(object):
-    """A directed multi-edge graph.
+    """A directed multi-edge graph with compact, column-wise storage.
 
     ExpressionGraph allows multiple edges between the same nodes,
     and respects the insertion order of nodes and edges.
+
+    Nodes are numbered consecutively in insertion order. The node data
+    is stored per attribute rather than per node:
+
+    - ``expressions``: list of the expression of each node
+    - ``e2i``: dict mapping expression to node index
+    - ``status``: bytearray with a status code (``INACTIVE``, ...) per node
+    - ``target``, ``component``, ``mt``, ``tr``: dicts of the (sparse)
+      attributes, keyed by node index
+
+    Edges are collected as pairs in typed arrays and compressed into
+    CSR arrays of out- and in-edges on first access.
     """
 
     def __init__(self):
-
-        # Data structures for directed multi-edge graph
-        self.nodes = {}
-        self.out_edges = {}
-        self.in_edges = {}
+        self.expressions = []
+        self.e2i = {}
+        self.status = bytearray()
+        self.target = {}
+        self.component = {}
+        self.mt = {}
+        self.tr = {}
+
+        self._sources = array.array("q")
+        self._targets = array.array("q")
+        self._csr = None
 
     def number_of_nodes(self):
-        return len(self.nodes)
+        return len(self.expressions)
 
-    def add_node(self, key, **kwargs):
-        """Add a node with optional properties."""
-        self.nodes[key] = kwargs
-        self.out_edges[key] = []
-        self.in_edges[key] = []
+    def add_node(self, expression):
+        """Add a node and return its index."""
+        self.expressions.append(expression)
+        return len(self.expressions) - 1
 
     def add_edge(self, node1, node2):
         """Add a directed edge from node1 to node2."""
-        if node1 not in self.nodes or node2 not in self.nodes:
+        n = len(self.expressions)
+        if not (0 <= node1 < n and 0 <= node2 < n):
             raise KeyError("Adding edge to unknown node")
 
-        self.out_edges[node1] += [node2]
-        self.in_edges[node2] += [node1]
+        self._sources.append(node1)
+        self._targets.append(node2)
+        self._csr = None
+
+    def number_of_edges(self):
+        return len(self._sources)
+
+    def out_edges(self, node):
+        """Return the list of nodes that node has edges to."""
+        offsets, targets = self._compressed()[0]
+        return targets[offsets[node]:offsets[node + 1]].tolist()
+
+    def in_edges(self, node):
+        """Return the list of nodes that have edges to node."""
+        offsets, sources = self._compressed()[1]
+        return sources[offsets[node]:offsets[node + 1]].tolist()
+
+    def nodes_with_status(self, status):
+        """Return the indices of the nodes with the given status name."""
+        codes = numpy.frombuffer(self.status, dtype=numpy.uint8) if self.status else numpy.zeros(0, numpy.uint8)
+        return numpy.flatnonzero(codes == status_codes[status]).tolist()
+
+    def _compressed(self):
+        if self._csr is None:
+            n = len(self.expressions)
+            sources = numpy.array(self._sources, dtype=numpy.int64)
+            targets = numpy.array(self._targets, dtype=numpy.int64)
+            self._csr = (_to_csr(sources, targets, n), _to_csr(targets, sources, n))
+        return self._csr
+
+
+def _to_csr(rows, columns, n):
+    """Compress (row, column) pairs, keeping the order of columns within each row."""
+    offsets = numpy.zeros(n + 1, dtype=numpy.int64)
+    numpy.cumsum(numpy.bincount(rows, minlength=n), out=offsets[1:])
+    return offsets, columns[numpy.argsort(rows, kind="stable")]
 
 
 def build_graph_vertices(expressions, skip_terminal_modifiers=False):
@@ -55,18 +115,13 @@ def build_graph_vertices(expressions, skip_terminal_modifiers=False):
     G.e2i = _count_nodes_with_unique_post_traversal(expressions, skip_terminal_modifiers)
 
     # Invert the map to get index->expression
-    GV = sorted(G.e2i, key=G.e2i.get)
-
-    # Add nodes to 'new' graph structure
-    for i, v in enumerate(GV):
-        G.add_node(i, expression=v)
+    G.expressions = sorted(G.e2i, key=G.e2i.get)
 
     for comp, expr in enumerate(expressions):
         # Get vertex index representing input expression root
         V_target = G.e2i[expr]
-        G.nodes[V_target]['target'] = True
-        G.nodes[V_target]['component'] = G.nodes[V_target].get("component", [])
-        G.nodes[V_target]['component'].append(comp)
+        G.target[V_target] = True
+        G.component.setdefault(V_target, []).append(comp)
 
     return G
 
@@ -84,21 +139,98 @@ def build_scalar_graph(expression):
     G = build_graph_vertices(scalar_expressions, skip_terminal_modifiers=True)
 
     # Compute graph edges
-    V_deps = []
-    for i, v in G.nodes.items():
-        expr = v['expression']
+    e2i = G.e2i
+    for i, expr in enumerate(G.expressions):
         if expr._ufl_is_terminal_ or expr._ufl_is_terminal_modifier_:
-            V_deps.append(())
+            continue
+        for o in expr.ufl_operands:
+            j = e2i[o]
+            if i != j:
+                G.add_edge(i, j)
+
+    return G
+
+
+def propagate_zeros(S, zero_nodes):
+    """Replace nodes of a scalar graph by zero and simplify the graph.
+
+    The expressions are rebuilt in a single topological sweep (operands
+    are stored before the nodes using them), reconstructing only nodes
+    with a changed operand. Nodes that become equal are merged,
+    expressions created by the simplification are inserted, and nodes
+    that are no longer reachable from the targets are removed.
+    """
+    G = ExpressionGraph()
+    zero = ufl.as_ufl(0.0)
+
+    # Map from node index in S to node index in G
+    new_index = []
+    for i, expr in enumerate(S.expressions):
+        if i in zero_nodes:
+            new_index.append(_insert_scalar(G, zero))
+            continue
+
+        deps = S.out_edges(i)
+        if any(G.expressions[new_index[j]] is not S.expressions[j] for j in deps):
+            expr = expr._ufl_expr_reconstruct_(*[G.expressions[new_index[j]] for j in deps])
+            new_index.append(_insert_scalar(G, expr))
         else:
-            V_deps.append([G.e2i[o] for o in expr.ufl_operands])
+            new_index.append(_insert_scalar(G, expr, [new_index[j] for j in deps]))
+
+    for comp, i in sorted((comp, new_index[t]) for t in S.target for comp in S.component[t]):
+        G.target[i] = True
+        G.component.setdefault(i, []).append(comp)
+
+    # Remove nodes no longer reachable from the targets
+    live = bytearray(G.number_of_nodes())
+    for i in G.target:
+        live[i] = 1
+    for i in reversed(range(G.number_of_nodes())):
+        if live[i]:
+            for j in G.out_edges(i):
+                live[j] = 1
+    if all(live):
+        return G
+
+    H = ExpressionGraph()
+    new_index = {}
+    for i, expr in enumerate(G.expressions):
+        if live[i]:
+            new_index[i] = H.add_node(expr)
+            H.e2i[expr] = new_index[i]
+    for i, k in new_index.items():
+        for j in G.out_edges(i):
+            H.add_edge(k, new_index[j])
+    for i, components in G.component.items():
+        H.target[new_index[i]] = True
+        H.component[new_index[i]] = components
+    return H
+
+
+def _insert_scalar(G, expr, operands=None):
+    """Insert an expression into a scalar graph unless present, and return its index.
+
+    The indices of the operands are looked up (inserting unknown
+    subexpressions) unless given. Edges follow ``build_scalar_graph``.
+    """
+    i = G.e2i.get(expr)
+    if i is not None:
+        return i
 
-    for i, edges in enumerate(V_deps):
-        for j in edges:
-            if i == j:
-                continue
-            G.add_edge(i, j)
+    if operands is None:
+        if expr._ufl_is_terminal_ or is_modified_terminal(expr):
+            operands = []
+        else:
+            operands = [_insert_scalar(G, o) for o in expr.ufl_operands
+                        if not isinstance(o, (ufl.classes.MultiIndex, ufl.classes.Label))]
 
-    return G
+    i = G.add_node(expr)
+    G.e2i[expr] = i
+    if not (expr._ufl_is_terminal_ or expr._ufl_is_terminal_modifier_):
+        for j in operands:
+            if i != j:
+                G.add_edge(i, j)
+    return i
 
 
 def rebuild_with_scalar_subexpressions(G):
@@ -129,8 +261,7 @@ def rebuild_with_scalar_subexpressions(G):
     W = numpy.empty(total_unique_symbols, dtype=object)
 
     # Iterate over each graph node in order
-    for i, v in G.nodes.items():
-        expr = v['expression']
+    for i, expr in enumerate(G.expressions):
         # Find symbols of v components
         vs = V_symbols[i]
 
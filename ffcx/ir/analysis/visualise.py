@@ -6,6 +6,7 @@
 """Utility to draw graphs."""
 
 
+from ffcx.ir.analysis.graph import status_codes
 from ffcx.ir.analysis.modified_terminals import strip_modified_terminal
 from ufl.classes import (Argument, Division, FloatValue, Indexed, IntValue,
                          Product, ReferenceValue, Sum)
@@ -23,8 +24,8 @@ def visualise_graph(Gx, filename):
         return
 
     G = pgv.AGraph(strict=False, directed=True)
-    for nd, v in Gx.nodes.items():
-        ex = v['expression']
+    status_names = {code: name for name, code in status_codes.items()}
+    for nd, ex in enumerate(Gx.expressions):
         label = ex.__class__.__name__
         if isinstance(ex, Sum):
             label = '+'
@@ -42,7 +43,7 @@ def visualise_graph(Gx, filename):
         if isinstance(arg, Argument):
             G.get_node(nd).attr['shape'] = 'box'
 
-        stat = v.get('status')
+        stat = status_names[Gx.status[nd]] if Gx.status else None
         if stat == 'piecewise':
             G.get_node(nd).attr['color'] = 'blue'
             G.get_node(nd).attr['penwidth'] = 5
@@ -53,17 +54,17 @@ def visualise_graph(Gx, filename):
             G.get_node(nd).attr['color'] = 'dimgray'
             G.get_node(nd).attr['penwidth'] = 5
 
-        t = v.get('target')
+        t = Gx.target.get(nd)
         if t:
             G.get_node(nd).attr['label'] += ':' + str(t)
             G.get_node(nd).attr['shape'] = 'hexagon'
 
-        c = v.get('component')
+        c = Gx.component.get(nd)
         if c:
             G.get_node(nd).attr['label'] += f", comp={c}"
 
-    for nd, eds in Gx.out_edges.items():
-        for ed in eds:
+    for nd in range(Gx.number_of_nodes()):
+        for ed in Gx.out_edges(nd):
             G.add_edge(nd, ed)
 
     G.layout(prog='dot')
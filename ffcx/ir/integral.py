@@ -10,11 +10,11 @@ import itertools
 import logging
 import typing
 
-import numpy
-
 import ufl
+from ffcx import profiling
 from ffcx.ir.analysis.factorization import compute_argument_factorization
-from ffcx.ir.analysis.graph import build_scalar_graph
+from ffcx.ir.analysis.graph import (ACTIVE, INACTIVE, PIECEWISE, VARYING,
+                                    build_scalar_graph, propagate_zeros)
 from ffcx.ir.analysis.modified_terminals import (analyse_modified_terminal,
                                                  is_modified_terminal)
 from ffcx.ir.analysis.visualise import visualise_graph
@@ -69,7 +69,9 @@ def compute_integral_ir(cell, integral_type, entitytype, integrands, argument_sh
         expression = replace_quadratureweight(expression)
 
         # Build initial scalar list-based graph representation
-        S = build_scalar_graph(expression)
+        with profiling.region("scalar graph", "ir") as counts:
+            S = build_scalar_graph(expression)
+            counts["num_nodes"] = len(S.expressions)
 
         # Build terminal_data from V here before factorization. Then we
         # can use it to derive table properties for all modified
@@ -77,51 +79,38 @@ def compute_integral_ir(cell, integral_type, entitytype, integrands, argument_sh
         # efficiently before argument factorization. We can build
         # terminal_data again after factorization if that's necessary.
 
-        initial_terminals = {i: analyse_modified_terminal(v['expression'])
-                             for i, v in S.nodes.items()
-                             if is_modified_terminal(v['expression'])}
-
-        mt_table_reference = build_optimized_tables(
-            quadrature_rule,
-            cell,
-            integral_type,
-            entitytype,
-            initial_terminals.values(),
-            ir["unique_tables"],
-            rtol=p["table_rtol"],
-            atol=p["table_atol"])
+        initial_terminals = {i: analyse_modified_terminal(v)
+                             for i, v in enumerate(S.expressions)
+                             if is_modified_terminal(v)}
+
+        with profiling.region("tables", "ir") as counts:
+            mt_table_reference = build_optimized_tables(
+                quadrature_rule,
+                cell,
+                integral_type,
+                entitytype,
+                initial_terminals.values(),
+                ir["unique_tables"],
+                rtol=p["table_rtol"],
+                atol=p["table_atol"])
+            counts["num_terminals"] = len(initial_terminals)
+            counts["num_tables"] = len({v.name for v in mt_table_reference.values()})
 
         # Fetch unique tables for this quadrature rule
         table_types = {v.name: v.ttype for v in mt_table_reference.values()}
         tables = {v.name: v.values for v in mt_table_reference.values()}
 
-        S_targets = [i for i, v in S.nodes.items() if v.get('target', False)]
-        num_components = numpy.int32(numpy.prod(expression.ufl_shape))
-
         if 'zeros' in table_types.values():
-            # If there are any 'zero' tables, replace symbolically and rebuild graph
+            # If there are any 'zero' tables, replace the modified
+            # terminals symbolically and simplify the graph
+            zero_nodes = set()
             for i, mt in initial_terminals.items():
-                # Set modified terminals with zero tables to zero
                 tr = mt_table_reference.get(mt)
                 if tr is not None and tr.ttype == "zeros":
-                    S.nodes[i]['expression'] = ufl.as_ufl(0.0)
-
-            # Propagate expression changes using dependency list
-            for i, v in S.nodes.items():
-                deps = [S.nodes[j]['expression'] for j in S.out_edges[i]]
-                if deps:
-                    v['expression'] = v['expression']._ufl_expr_reconstruct_(*deps)
-
-            # Recreate expression with correct ufl_shape
-            expressions = [None, ] * num_components
-            for target in S_targets:
-                for comp in S.nodes[target]["component"]:
-                    assert expressions[comp] is None
-                    expressions[comp] = S.nodes[target]["expression"]
-            expression = ufl.as_tensor(numpy.reshape(expressions, expression.ufl_shape))
-
-            # Rebuild scalar list-based graph representation
-            S = build_scalar_graph(expression)
+                    zero_nodes.add(i)
+            with profiling.region("zero propagation", "ir") as counts:
+                S = propagate_zeros(S, zero_nodes)
+                counts["num_nodes"] = len(S.expressions)
 
         # Output diagnostic graph as pdf
         if visualise:
@@ -129,21 +118,24 @@ def compute_integral_ir(cell, integral_type, entitytype, integrands, argument_sh
 
         # Compute factorization of arguments
         rank = len(argument_shape)
-        F = compute_argument_factorization(S, rank)
+        with profiling.region("factorisation", "ir") as counts:
+            F = compute_argument_factorization(S, rank)
+            counts["num_nodes"] = len(F.expressions)
+            counts["num_edges"] = F.number_of_edges()
 
         # Get the 'target' nodes that are factors of arguments, and insert in dict
-        FV_targets = [i for i, v in F.nodes.items() if v.get('target', False)]
+        FV_targets = sorted(F.target)
         argument_factorization = {}
 
         for fi in FV_targets:
             # Number of blocks using this factor must agree with number of components
             # to which this factor contributes. I.e. there are more blocks iff there are more
             # components
-            assert len(F.nodes[fi]['target']) == len(F.nodes[fi]['component'])
+            assert len(F.target[fi]) == len(F.component[fi])
 
             k = 0
-            for w in F.nodes[fi]['target']:
-                comp = F.nodes[fi]['component'][k]
+            for w in F.target[fi]:
+                comp = F.component[fi][k]
                 argument_factorization[w] = argument_factorization.get(w, [])
 
                 # Store tuple of (factor index, component index)
@@ -158,14 +150,13 @@ def compute_integral_ir(cell, integral_type, entitytype, integrands, argument_sh
 
         # Build set of modified_terminals for each mt factorized vertex in F
         # and attach tables, if appropriate
-        for i, v in F.nodes.items():
-            expr = v['expression']
+        for i, expr in enumerate(F.expressions):
             if is_modified_terminal(expr):
                 mt = analyse_modified_terminal(expr)
-                F.nodes[i]['mt'] = mt
+                F.mt[i] = mt
                 tr = mt_table_reference.get(mt)
                 if tr is not None:
-                    F.nodes[i]['tr'] = tr
+                    F.tr[i] = tr
 
         # Attach 'status' to each node: 'inactive', 'piecewise' or 'varying'
         analyse_dependencies(F, mt_table_reference)
@@ -179,7 +170,7 @@ def compute_integral_ir(cell, integral_type, entitytype, integrands, argument_sh
         for ma_indices, fi_ci in sorted(argument_factorization.items()):
             # Get a bunch of information about this term
             assert rank == len(ma_indices)
-            trs = tuple(F.nodes[ai]['tr'] for ai in ma_indices)
+            trs = tuple(F.tr[ai] for ai in ma_indices)
 
             unames = tuple(tr.name for tr in trs)
             ttypes = tuple(tr.ttype for tr in trs)
@@ -202,13 +193,13 @@ def compute_integral_ir(cell, integral_type, entitytype, integrands, argument_sh
                 if trs[i].is_uniform:
                     r = None
                 else:
-                    r = F.nodes[ai]['mt'].restriction
+                    r = F.mt[ai].restriction
 
                 block_restrictions.append(r)
             block_restrictions = tuple(block_restrictions)
 
             # Check if each *each* factor corresponding to this argument is piecewise
-            all_factors_piecewise = all(F.nodes[ifi[0]]["status"] == 'piecewise' for ifi in fi_ci)
+            all_factors_piecewise = all(F.status[ifi[0]] == PIECEWISE for ifi in fi_ci)
             block_is_permuted = False
             for name in unames:
                 if tables[name].shape[0] > 1:
@@ -229,9 +220,8 @@ def compute_integral_ir(cell, integral_type, entitytype, integrands, argument_sh
 
         # Figure out which table names are referenced
         active_table_names = set()
-        for i, v in F.nodes.items():
-            tr = v.get('tr')
-            if tr is not None and F.nodes[i]['status'] != 'inactive':
+        for i, tr in F.tr.items():
+            if F.status[i] != INACTIVE:
                 active_table_names.add(tr.name)
 
         # Figure out which table names are referenced in blocks
@@ -256,7 +246,7 @@ def compute_integral_ir(cell, integral_type, entitytype, integrands, argument_sh
         # Build IR dict for the given expressions
         # Store final ir for this num_points
         ir["integrand"][quadrature_rule] = {"factorization": F,
-                                            "modified_arguments": [F.nodes[i]['mt'] for i in argkeys],
+                                            "modified_arguments": [F.mt[i] for i in argkeys],
                                             "block_contributions": block_contributions}
 
         restrictions = [i.restriction for i in initial_terminals.values()]
@@ -273,24 +263,21 @@ def analyse_dependencies(F, mt_unique_table_reference):
     # nodes are also set to 'varying' - any remaining active nodes are 'piecewise'.
 
     # Set targets, and dependencies to 'active'
-    targets = [i for i, v in F.nodes.items() if v.get('target')]
-    for i, v in F.nodes.items():
-        v['status'] = 'inactive'
+    targets = sorted(F.target)
+    status = bytearray(F.number_of_nodes())  # all INACTIVE
 
     while targets:
         s = targets.pop()
-        F.nodes[s]['status'] = 'active'
-        for j in F.out_edges[s]:
-            if F.nodes[j]['status'] == 'inactive':
+        status[s] = ACTIVE
+        for j in F.out_edges(s):
+            if status[j] == INACTIVE:
                 targets.append(j)
 
     # Build piecewise/varying markers for factorized_vertices
     varying_ttypes = ("varying", "quadrature", "uniform")
     varying_indices = []
-    for i, v in F.nodes.items():
-        if v.get('mt') is None:
-            continue
-        tr = v.get('tr')
+    for i in sorted(F.mt):
+        tr = F.tr.get(i)
         if tr is not None:
             ttype = tr.ttype
             # Check if table computations have revealed values varying over points
@@ -300,7 +287,7 @@ def analyse_dependencies(F, mt_unique_table_reference):
                 if ttype not in ("fixed", "piecewise", "ones", "zeros"):
                     raise RuntimeError("Invalid ttype %s" % (ttype, ))
 
-        elif not is_cellwise_constant(v['expression']):
+        elif not is_cellwise_constant(F.expressions[i]):
             raise RuntimeError("Error " + str(tr))
             # Keeping this check to be on the safe side,
             # not sure which cases this will cover (if any)
@@ -309,15 +296,12 @@ def analyse_dependencies(F, mt_unique_table_reference):
     # Set all parents of active varying nodes to 'varying'
     while varying_indices:
         s = varying_indices.pop()
-        if F.nodes[s]['status'] == 'active':
-            F.nodes[s]['status'] = 'varying'
-            for j in F.in_edges[s]:
-                varying_indices.append(j)
+        if status[s] == ACTIVE:
+            status[s] = VARYING
+            varying_indices.extend(F.in_edges(s))
 
     # Any remaining active nodes must be 'piecewise'
-    for i, v in F.nodes.items():
-        if v['status'] == 'active':
-            v['status'] = 'piecewise'
+    F.status = status.replace(bytes([ACTIVE]), bytes([PIECEWISE]))
 
 
 def replace_quadratureweight(expression):
@@ -16,9 +16,13 @@ should only need to use the data stored in the intermediate
 representation under the key "foo".
 """
 
+import concurrent.futures
 import itertools
 import logging
+import multiprocessing
 import numbers
+import os
+import pickle
 import typing
 import warnings
 
@@ -26,7 +30,7 @@ import numpy
 
 import basix
 import ufl
-from ffcx import naming
+from ffcx import naming, profiling
 from ffcx.analysis import UFLData
 from ffcx.element_interface import convert_element
 from ffcx.ir.integral import compute_integral_ir
@@ -125,7 +129,10 @@ class IntegralIR(typing.NamedTuple):
     tensor_shape: typing.List[int]
     coefficient_numbering: typing.Dict[ufl.Coefficient, int]
     coefficient_offsets: typing.Dict[ufl.Coefficient, int]
+    num_coefficient_values: int
     original_constant_offsets: typing.Dict[ufl.Constant, int]
+    num_constant_values: int
+    num_coordinate_dofs: int
     options: dict
     cell_shape: str
     unique_tables: typing.Dict[str, numpy.typing.NDArray[numpy.float64]]
@@ -197,12 +204,20 @@ def compute_ir(analysis: UFLData, object_names, prefix, options, visualise):
         for e in analysis.unique_elements
     ]
 
-    irs = [
-        _compute_integral_ir(fd, i, analysis.element_numbers, integral_names, finite_element_names,
+    # Prepare the integrals of all forms, then compute the expensive part
+    # of their representations (possibly in parallel)
+    prepared = list(itertools.chain(*[
+        _prepare_integral_ir(fd, i, analysis.element_numbers, integral_names, finite_element_names,
                              options, visualise)
         for (i, fd) in enumerate(analysis.form_data)
-    ]
-    ir_integrals = list(itertools.chain(*irs))
+    ]))
+    integral_irs = _compute_integral_irs([(ir["name"], arguments) for ir, arguments in prepared],
+                                         options["ir_workers"])
+
+    ir_integrals = []
+    for (ir, _), integral_ir in zip(prepared, integral_irs):
+        ir.update(integral_ir)
+        ir_integrals.append(IntegralIR(**ir))
 
     ir_forms = [
         _compute_form_ir(fd, i, prefix, form_names, integral_names, analysis.element_numbers, finite_element_names,
@@ -327,9 +342,14 @@ def _compute_dofmap_ir(element, element_numbers, dofmap_names):
     return DofMapIR(**ir)
 
 
-def _compute_integral_ir(form_data, form_index, element_numbers, integral_names,
+def _prepare_integral_ir(form_data, form_index, element_numbers, integral_names,
                          finite_element_names, options, visualise):
-    """Compute intermediate representation for form integrals."""
+    """Prepare the intermediate representation of form integrals.
+
+    Returns a list with a pair for each integral: the representation
+    computed so far and the arguments of ``compute_integral_ir``, which
+    computes the rest.
+    """
     _entity_types = {
         "cell": "cell",
         "exterior_facet": "facet",
@@ -350,6 +370,7 @@ def _compute_integral_ir(form_data, form_index, element_numbers, integral_names,
         cellname = cell.cellname()
         tdim = cell.topological_dimension()
         assert all(tdim == itg.ufl_domain().topological_dimension() for itg in itg_data.integrals)
+        coordinate_element = convert_element(itg_data.domain.ufl_coordinate_element())
 
         ir = {
             "integral_type": itg_data.integral_type,
@@ -362,7 +383,8 @@ def _compute_integral_ir(form_data, form_index, element_numbers, integral_names,
             "num_vertices": cell.num_vertices(),
             "enabled_coefficients": itg_data.enabled_coefficients,
             "cell_shape": cellname,
-            "coordinate_element": finite_element_names[convert_element(itg_data.domain.ufl_coordinate_element())]
+            "coordinate_element": finite_element_names[coordinate_element],
+            "num_coordinate_dofs": coordinate_element.dim // coordinate_element.block_size
         }
 
         # Get element space dimensions
@@ -467,6 +489,7 @@ def _compute_integral_ir(form_data, form_index, element_numbers, integral_names,
 
         # Copy offsets also into IR
         ir["coefficient_offsets"] = offsets
+        ir["num_coefficient_values"] = _offset
 
         # Build offsets for Constants
         original_constant_offsets = {}
@@ -476,26 +499,80 @@ def _compute_integral_ir(form_data, form_index, element_numbers, integral_names,
             _offset += numpy.product(constant.ufl_shape, dtype=int)
 
         ir["original_constant_offsets"] = original_constant_offsets
+        ir["num_constant_values"] = int(_offset)
         ir["precision"] = itg_data.metadata["precision"]
 
         # Create map from number of quadrature points -> integrand
         integrands = {rule: integral.integrand() for rule, integral in sorted_integrals.items()}
 
-        # Build more specific intermediate representation
-        integral_ir = compute_integral_ir(itg_data.domain.ufl_cell(), itg_data.integral_type,
-                                          ir["entitytype"], integrands, ir["tensor_shape"],
-                                          options, visualise)
-
-        ir.update(integral_ir)
-
         # Fetch name
         ir["name"] = integral_names[(form_index, itg_data_index)]
 
-        irs.append(IntegralIR(**ir))
+        # Arguments to build more specific intermediate representation
+        arguments = (itg_data.domain.ufl_cell(), itg_data.integral_type, ir["entitytype"], integrands,
+                     ir["tensor_shape"], options, visualise)
+
+        irs.append((ir, arguments))
 
     return irs
 
 
+class _TransferError(Exception):
+    """A result of a worker process could not be pickled."""
+
+
+def _compute_integral_ir_region(name, arguments):
+    with profiling.region(name, "integral", integral_type=arguments[1]):
+        return compute_integral_ir(*arguments)
+
+
+def _compute_integral_ir_worker(job):
+    # The job is a pickled pair of integral name and arguments. Return
+    # the profiling events of the worker along with the IR.
+    profiling.take_events()
+    ir = _compute_integral_ir_region(*pickle.loads(job))
+    try:
+        return pickle.dumps((ir, profiling.take_events()))
+    except (pickle.PicklingError, TypeError, AttributeError) as e:
+        raise _TransferError(repr(e)) from None
+
+
+def _compute_integral_irs(arguments, workers):
+    """Call compute_integral_ir for each pair of integral name and arguments.
+
+    With more than one worker the integrals are computed by a pool of
+    processes, which are started fresh (not forked from this possibly
+    multi-threaded process) and get the arguments of each integral with
+    the job. This falls back to computing sequentially if the arguments
+    or results cannot be pickled or the processes cannot be started.
+    Errors in the computation itself are raised. The result does not
+    depend on the number of workers.
+    """
+    workers = workers if workers > 0 else (os.cpu_count() or 1)
+    workers = min(workers, len(arguments))
+    if workers > 1:
+        try:
+            jobs = [pickle.dumps(a) for a in arguments]
+        except (pickle.PicklingError, TypeError, AttributeError) as e:
+            logger.warning(f"Cannot pass integrals to worker processes ({e!r}), computing IR sequentially.")
+            jobs = None
+
+        if jobs is not None:
+            methods = multiprocessing.get_all_start_methods()
+            context = multiprocessing.get_context("forkserver" if "forkserver" in methods else "spawn")
+            try:
+                with concurrent.futures.ProcessPoolExecutor(workers, mp_context=context) as pool:
+                    results = [pickle.loads(r) for r in pool.map(_compute_integral_ir_worker, jobs)]
+            except (_TransferError, concurrent.futures.BrokenExecutor, OSError) as e:
+                logger.warning(f"Parallel IR computation failed ({e!r}), computing sequentially.")
+            else:
+                for _, events in results:
+                    profiling.add_events(events)
+                return [ir for ir, _ in results]
+
+    return [_compute_integral_ir_region(name, a) for name, a in arguments]
+
+
 def _compute_form_ir(form_data, form_id, prefix, form_names, integral_names, element_numbers, finite_element_names,
                      dofmap_names, object_names) -> FormIR:
     """Compute intermediate representation of form."""
@@ -9,15 +9,22 @@ Parse command-line arguments and generate code from input UFL form files.
 """
 
 import argparse
+import concurrent.futures
 import cProfile
+import io
 import logging
+import os
 import pathlib
 import re
+import site
 import string
+import sys
+import traceback
+import warnings
 
 import ufl
 from ffcx import __version__ as FFCX_VERSION
-from ffcx import compiler, formatting
+from ffcx import compiler, formatting, profiling
 from ffcx.options import FFCX_DEFAULT_OPTIONS, get_options
 
 logger = logging.getLogger("ffcx")
@@ -29,52 +36,187 @@ parser.add_argument(
 parser.add_argument("-o", "--output-directory", type=str, default=".", help="output directory")
 parser.add_argument("--visualise", action="store_true", help="visualise the IR graph")
 parser.add_argument("-p", "--profile", action='store_true', help="enable profiling")
+parser.add_argument("-j", "--jobs", type=int, default=1,
+                    help="number of files to compile in parallel (0 to use all cores)")
+parser.add_argument("--depfile", action="store_true",
+                    help="write a make-style dependency file <prefix>.d for each UFL file")
+parser.add_argument("--manifest", action="store_true",
+                    help="write a JSON description of the generated kernels <prefix>.json for each UFL file")
+parser.add_argument("--trace", type=str, metavar="FILE",
+                    help="write a timing trace of the compiler stages, forms and integrals "
+                    "to FILE (Chrome trace event format)")
+
+
+def parse_bool(value):
+    """Parse the value of a boolean option on the command line."""
+    if value.lower() in ("1", "true", "yes"):
+        return True
+    elif value.lower() in ("0", "false", "no"):
+        return False
+    raise argparse.ArgumentTypeError(f"invalid boolean value: '{value}'")
+
+
+def add_option_arguments(parser):
+    """Add all options from FFCx option system to an argument parser."""
+    for opt_name, (opt_val, opt_desc) in FFCX_DEFAULT_OPTIONS.items():
+        # bool("False") is True, so booleans need their own parser
+        opt_type = parse_bool if isinstance(opt_val, bool) else type(opt_val)
+        parser.add_argument(f"--{opt_name}",
+                            type=opt_type, help=f"{opt_desc} (default={opt_val})")
+
+
+add_option_arguments(parser)
+parser.add_argument("ufl_file", nargs='+', help="UFL file(s) to be compiled")
 
-# Add all options from FFCx option system
-for opt_name, (opt_val, opt_desc) in FFCX_DEFAULT_OPTIONS.items():
-    parser.add_argument(f"--{opt_name}",
-                        type=type(opt_val), help=f"{opt_desc} (default={opt_val})")
 
-parser.add_argument("ufl_file", nargs='+', help="UFL file(s) to be compiled")
+def file_prefix(filename):
+    """Return the prefix of generated names and files for a UFL file."""
+    # Remove weird characters (file system allows more than the C
+    # preprocessor)
+    prefix = pathlib.Path(filename).stem
+    prefix = re.subn("[^{}]".format(string.ascii_letters + string.digits + "_"), "!", prefix)[0]
+    prefix = re.subn("!+", "_", prefix)[0]
+    return prefix
 
 
-def main(args=None):
-    xargs = parser.parse_args(args)
+def _is_user_file(path):
+    """Check if a Python file belongs to the user rather than an installation."""
+    system_paths = [sys.prefix, sys.base_prefix, sys.exec_prefix, site.getusersitepackages()]
+    system_paths += site.getsitepackages()
+    path = os.path.realpath(path)
+    return not any(path.startswith(os.path.realpath(p) + os.sep) for p in system_paths)
 
-    # Parse all other options
-    priority_options = {k: v for k, v in xargs.__dict__.items() if v is not None}
-    options = get_options(priority_options)
 
-    # Call parser and compiler for each file
-    for filename in xargs.ufl_file:
-        file = pathlib.Path(filename)
+def _load_ufl_file(filename):
+    """Load a UFL file, and find the Python files it imports.
+
+    Modules imported from outside the Python installation are assumed to
+    be part of the user's sources. They are unloaded again after the
+    file has been loaded, so that the imports of every UFL file are
+    found even when several files are compiled in one process.
+
+    """
+    modules = set(sys.modules)
+    ufd = ufl.algorithms.load_ufl_file(filename)
 
-        # Remove weird characters (file system allows more than the C
-        # preprocessor)
-        prefix = file.stem
-        prefix = re.subn("[^{}]".format(string.ascii_letters + string.digits + "_"), "!", prefix)[0]
-        prefix = re.subn("!+", "_", prefix)[0]
+    dependencies = [filename]
+    for name in set(sys.modules) - modules:
+        path = getattr(sys.modules[name], "__file__", None)
+        if name.split(".")[0] in ("ffcx", "ufl", "basix") or path is None or not path.endswith(".py"):
+            continue
+        if _is_user_file(path):
+            dependencies.append(path)
+            del sys.modules[name]
 
-        # Turn on profiling
-        if xargs.profile:
-            pr = cProfile.Profile()
-            pr.enable()
+    return ufd, dependencies[:1] + sorted(dependencies[1:])
 
+
+def _compile_file(filename, options, output_directory, visualise, profile, depfile, manifest):
+    """Compile a UFL file and write the generated code to file."""
+    prefix = file_prefix(filename)
+
+    # Turn on profiling
+    if profile:
+        pr = cProfile.Profile()
+        pr.enable()
+
+    with profiling.region(filename, "file"):
         # Load UFL file
-        ufd = ufl.algorithms.load_ufl_file(filename)
+        with profiling.region("load UFL file", "stage"):
+            ufd, dependencies = _load_ufl_file(filename)
+
+        # Generate code and write to file. Files with unchanged content
+        # are not rewritten.
+        compiler.write_ufl_objects(
+            ufd.forms + ufd.expressions + ufd.elements, output_directory, ufd.object_names,
+            prefix=prefix, options=options, visualise=visualise, manifest=manifest)
+    if depfile:
+        extensions = (".h", ".c", ".json") if manifest else (".h", ".c")
+        targets = [os.path.join(output_directory, prefix + ext) for ext in extensions]
+        formatting.write_depfile(targets, dependencies, prefix, output_directory)
+
+    # Turn off profiling and write status to file
+    if profile:
+        pr.disable()
+        pfn = f"ffcx_{prefix}.profile"
+        pr.dump_stats(pfn)
+
+
+def _compile_file_captured(filename, options, output_directory, visualise, profile, depfile, manifest, trace):
+    """Compile a UFL file in a worker process.
+
+    Log messages and warnings are captured rather than printed, so that
+    the parent can print them in the order of the input files. Returns
+    the captured output, whether compilation succeeded and the recorded
+    profiling events.
+
+    """
+    if trace:
+        profiling.enable()
+    output = io.StringIO()
+    handler = logging.StreamHandler(output)
+    logger.addHandler(handler)
+    logger.setLevel(options["verbosity"])
+    logger.propagate = False
+    try:
+        with warnings.catch_warnings():
+            warnings.showwarning = lambda message, category, filename, lineno, file=None, line=None: \
+                output.write(warnings.formatwarning(message, category, filename, lineno, line))
+            _compile_file(filename, options, output_directory, visualise, profile, depfile, manifest)
+        success = True
+    except Exception:
+        output.write(f"Compilation of {filename} failed:\n" + traceback.format_exc())
+        success = False
+    finally:
+        logger.removeHandler(handler)
+        logger.propagate = True
+
+    return output.getvalue(), success, profiling.disable()
 
-        # Generate code
-        code_h, code_c = compiler.compile_ufl_objects(
-            ufd.forms + ufd.expressions + ufd.elements, ufd.object_names,
-            prefix=prefix, options=options, visualise=xargs.visualise)
 
-        # Write to file
-        formatting.write_code(code_h, code_c, prefix, xargs.output_directory)
+def main(args=None):
+    xargs = parser.parse_args(args)
 
-        # Turn off profiling and write status to file
-        if xargs.profile:
-            pr.disable()
-            pfn = f"ffcx_{prefix}.profile"
-            pr.dump_stats(pfn)
+    # Parse all other options
+    priority_options = {k: v for k, v in xargs.__dict__.items() if v is not None and k in FFCX_DEFAULT_OPTIONS}
+    options = get_options(priority_options)
 
-    return 0
+    if xargs.trace:
+        profiling.enable()
+    status = _compile_files(xargs, options)
+    if xargs.trace:
+        profiling.write_trace(xargs.trace, profiling.disable())
+
+    return status
+
+
+def _compile_files(xargs, options):
+    """Call parser and compiler for each file."""
+    jobs = xargs.jobs if xargs.jobs > 0 else os.cpu_count()
+    status = 0
+    if jobs == 1 or len(xargs.ufl_file) == 1:
+        # A failing file is reported and the others are still compiled,
+        # as in worker processes
+        for filename in xargs.ufl_file:
+            try:
+                _compile_file(filename, options, xargs.output_directory, xargs.visualise, xargs.profile,
+                              xargs.depfile, xargs.manifest)
+            except Exception:
+                sys.stderr.write(f"Compilation of {filename} failed:\n" + traceback.format_exc())
+                status = 1
+        return status
+
+    # Compile files in worker processes, and print their output in the
+    # order of the input files
+    with concurrent.futures.ProcessPoolExecutor(min(jobs, len(xargs.ufl_file))) as pool:
+        futures = [pool.submit(_compile_file_captured, filename, options, xargs.output_directory,
+                               xargs.visualise, xargs.profile, xargs.depfile, xargs.manifest, bool(xargs.trace))
+                   for filename in xargs.ufl_file]
+        for future in futures:
+            output, success, events = future.result()
+            sys.stderr.write(output)
+            profiling.add_events(events)
+            if not success:
+                status = 1
+
+    return status
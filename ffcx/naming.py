@@ -119,6 +119,19 @@ def cdtype_to_numpy(cdtype: str):
         raise RuntimeError(f"Unknown NumPy type for: {cdtype}")
 
 
+# Size in bytes of the C types used in kernels, most specific first
+_c_type_sizes = (("long double _Complex", 32), ("double _Complex", 16), ("float _Complex", 8),
+                 ("long double", 16), ("double", 8), ("float", 4), ("uint8_t", 1), ("bool", 1), ("int", 4))
+
+
+def c_type_size(typename: str) -> int:
+    """Return the size in bytes of a C scalar type, ignoring qualifiers such as static or const."""
+    for name, size in _c_type_sizes:
+        if name in typename:
+            return size
+    raise RuntimeError(f"Unknown size of type: {typename}")
+
+
 def scalar_to_value_type(scalar_type: str) -> str:
     """The C value type associated with a C scalar type.
 
@@ -33,6 +33,29 @@ FFCX_DEFAULT_OPTIONS = {
                (-1 means no alignment assumed, safe option)"""),
     "padlen":
         (1, "Pads every declared array in tabulation kernel such that its last dimension is divisible by given value."),
+    "target_clones":
+        ("", """Comma separated list of instruction set targets, e.g. "avx2,avx512f". If given, every
+                tabulate_tensor function is compiled once per target (and once for "default") and the
+                variant matching the CPU is selected when the module is loaded (requires GCC >= 6 or
+                Clang >= 14 on an ELF platform)."""),
+    "instrument_kernels":
+        (False, """True to count the calls of each tabulate_tensor function and the time spent in it, in the
+                 statistics member of ufcx_integral (requires GCC or Clang and POSIX clock_gettime)."""),
+    "tabulate_action":
+        (False, """True to generate the matrix-free tabulate_action kernels of bilinear integrals, which roughly
+                 doubles the generation time and size of their code."""),
+    "tabulate_functional":
+        (False, """True to generate the batched tabulate_functional kernels of rank 0 integrals, which inline a
+                 second copy of the tabulate_tensor body."""),
+    "functional_compensated_summation":
+        (False, """True to sum the entity contributions in the batched functional kernels
+                 (tabulate_functional) with Kahan summation. Requires value-safe floating point
+                 optimisation, i.e. no -ffast-math."""),
+    "ir_workers":
+        (1, """Number of processes computing the intermediate representation of integrals in parallel
+               (0 means one per CPU core). Does not change the generated code. The processes are
+               started fresh, so scripts using this must guard their main code with
+               if __name__ == "__main__"."""),
     "verbosity":
         (30, "Logger verbosity. Follows standard logging library levels, i.e. INFO=20, DEBUG=10, etc.")
 }
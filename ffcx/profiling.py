@@ -0,0 +1,92 @@
+# Copyright (C) 2022 FEniCS Project
+#
+# This file is part of FFCx. (https://www.fenicsproject.org)
+#
+# SPDX-License-Identifier:    LGPL-3.0-or-later
+"""Structured profiling of the compiler.
+
+Regions of the compilation (stages, forms, integrals, C compilation) are
+recorded as events in the Chrome trace event format, which can be viewed
+with chrome://tracing or https://ui.perfetto.dev. Each region can carry
+arguments, such as the number of graph nodes or tables of an integral.
+
+Recording is off by default, and a region is then only a function call.
+Use it as::
+
+    ffcx.profiling.enable()
+    ...  # compile
+    ffcx.profiling.write_trace("ffcx_trace.json")
+
+or pass ``--trace`` to the ffcx command-line tool.
+"""
+
+import contextlib
+import json
+import os
+import threading
+import time
+import typing
+
+# Recorded events, or None when recording is off
+_events: typing.Optional[typing.List[dict]] = None
+
+
+def enable():
+    """Start recording events, discarding previously recorded events."""
+    global _events
+    _events = []
+
+
+def disable() -> typing.List[dict]:
+    """Stop recording events and return the recorded events."""
+    global _events
+    events, _events = _events or [], None
+    return events
+
+
+def is_enabled() -> bool:
+    """Check if events are being recorded."""
+    return _events is not None
+
+
+def take_events() -> typing.List[dict]:
+    """Return the events recorded so far and continue recording with an empty list."""
+    global _events
+    if _events is None:
+        return []
+    events, _events = _events, []
+    return events
+
+
+def add_events(events: typing.List[dict]):
+    """Add events recorded elsewhere, e.g. by a worker process."""
+    if _events is not None:
+        _events.extend(events)
+
+
+@contextlib.contextmanager
+def region(name: str, category: str, **args):
+    """Record the time spent in a region of the compiler.
+
+    Yields the dictionary of arguments of the event, which can be
+    updated with counts computed in the region.
+    """
+    if _events is None:
+        yield args
+        return
+
+    start = time.perf_counter_ns()
+    try:
+        yield args
+    finally:
+        end = time.perf_counter_ns()
+        _events.append({"name": name, "cat": category, "ph": "X", "ts": start / 1000, "dur": (end - start) / 1000,
+                        "pid": os.getpid(), "tid": threading.get_ident(), "args": args})
+
+
+def write_trace(filename: str, events: typing.Optional[typing.List[dict]] = None):
+    """Write recorded events to file in the Chrome trace event format."""
+    if events is None:
+        events = _events or []
+    with open(filename, "w") as f:
+        json.dump({"traceEvents": events, "displayTimeUnit": "ms"}, f)
@@ -4,8 +4,10 @@
 #
 # SPDX-License-Identifier:    LGPL-3.0-or-later
 
+import json
 import os
 import os.path
+import shutil
 import subprocess
 
 
@@ -19,3 +21,116 @@ def test_visualise():
     subprocess.run(["ffcx", "--visualise", "Poisson.py"])
     assert os.path.isfile("S.pdf")
     assert os.path.isfile("F.pdf")
+
+
+def test_bool_options():
+    import ffcx.bundle
+    import ffcx.main
+
+    for parser in (ffcx.main.parser, ffcx.bundle.parser):
+        assert parser.parse_args(["--instrument_kernels", "False", "Poisson.py"]).instrument_kernels is False
+        assert parser.parse_args(["--instrument_kernels", "true", "Poisson.py"]).instrument_kernels is True
+        assert parser.parse_args(["Poisson.py"]).instrument_kernels is None
+
+
+def test_bundle(tmp_path):
+    import ffcx.bundle
+    import ffcx.codegeneration.jit
+    import ufl
+
+    poisson = os.path.join(os.path.dirname(__file__), "Poisson.py")
+    library = str(tmp_path / "libpoisson.so")
+    assert ffcx.bundle.main(["-o", library, poisson]) == 0
+
+    ffcx.codegeneration.jit.register_bundle(library)
+    forms = ufl.algorithms.load_ufl_file(poisson).forms
+    compiled_forms, module, code = ffcx.codegeneration.jit.compile_forms(forms)
+    assert module.__file__ == library
+    assert code == (None, None)
+    assert [f.rank for f in compiled_forms] == [2, 1]
+
+
+def test_jobs(tmp_path):
+    poisson = os.path.join(os.path.dirname(__file__), "Poisson.py")
+    files = []
+    for name in ["first.py", "second.py"]:
+        files.append(str(tmp_path / name))
+        shutil.copyfile(poisson, files[-1])
+    broken = str(tmp_path / "broken.py")
+    with open(broken, "w") as f:
+        f.write("a = undefined_name\n")
+
+    sequential, parallel = tmp_path / "sequential", tmp_path / "parallel"
+    sequential.mkdir()
+    parallel.mkdir()
+    subprocess.run(["ffcx", "-o", str(sequential)] + files, check=True)
+    result = subprocess.run(["ffcx", "-j", "2", "-o", str(parallel)] + files)
+    assert result.returncode == 0
+    for name in ["first.h", "first.c", "second.h", "second.c"]:
+        assert sequential.joinpath(name).read_text() == parallel.joinpath(name).read_text()
+
+    # Failures are reported in the order of the input files, and the
+    # other files are still compiled
+    for output, jobs in ((sequential, "1"), (parallel, "2")):
+        output.joinpath("first.c").unlink()
+        result = subprocess.run(["ffcx", "-j", jobs, "-o", str(output), broken] + files,
+                                stderr=subprocess.PIPE, text=True)
+        assert result.returncode == 1
+        assert "Compilation of " + broken + " failed" in result.stderr
+        assert output.joinpath("first.c").exists()
+
+
+def test_depfile(tmp_path):
+    poisson = str(tmp_path / "poisson_dep.py")
+    shutil.copyfile(os.path.join(os.path.dirname(__file__), "Poisson.py"), poisson)
+    tmp_path.joinpath("poisson_common.py").write_text("degree = 1\n")
+    with open(poisson, "a") as f:
+        f.write("import poisson_common  # noqa\n")
+    env = dict(os.environ, PYTHONPATH=str(tmp_path))
+
+    subprocess.run(["ffcx", "--depfile", "-o", str(tmp_path), poisson], env=env, check=True)
+    depfile = tmp_path.joinpath("poisson_dep.d").read_text()
+    assert depfile.startswith(f"{tmp_path / 'poisson_dep.h'} {tmp_path / 'poisson_dep.c'}:")
+    assert poisson in depfile
+    assert "poisson_common.py" in depfile
+
+    # Unchanged output is not rewritten
+    mtimes = [tmp_path.joinpath(name).stat().st_mtime_ns for name in ["poisson_dep.h", "poisson_dep.c"]]
+    subprocess.run(["ffcx", "--depfile", "-o", str(tmp_path), poisson], env=env, check=True)
+    assert mtimes == [tmp_path.joinpath(name).stat().st_mtime_ns for name in ["poisson_dep.h", "poisson_dep.c"]]
+
+
+def test_trace(tmp_path):
+    poisson = os.path.join(os.path.dirname(__file__), "Poisson.py")
+    trace = tmp_path / "trace.json"
+    subprocess.run(["ffcx", "--trace", str(trace), "-o", str(tmp_path), poisson], check=True)
+
+    events = json.loads(trace.read_text())["traceEvents"]
+    names = {e["name"] for e in events}
+    for name in ["analysis", "intermediate representation", "code generation and formatting", "tables",
+                 "factorisation", "kernel ast"]:
+        assert name in names
+    integrals = [e for e in events if e["cat"] == "integral"]
+    assert len(integrals) == 2
+    assert all(e["ph"] == "X" and e["dur"] >= 0 for e in events)
+    factorisation = [e for e in events if e["name"] == "factorisation"]
+    assert all(e["args"]["num_nodes"] > 0 for e in factorisation)
+
+
+def test_manifest(tmp_path):
+    poisson = os.path.join(os.path.dirname(__file__), "Poisson.py")
+    subprocess.run(["ffcx", "--manifest", "-o", str(tmp_path), poisson], check=True)
+
+    manifest = json.loads((tmp_path / "Poisson.json").read_text())
+    assert manifest["scalar_type"] == "double"
+    assert [form["rank"] for form in manifest["forms"]] == [2, 1]
+    assert len(manifest["integrals"]) == 2
+    for integral in manifest["integrals"]:
+        assert integral["name"] in (tmp_path / "Poisson.c").read_text()
+        assert integral["integral_type"] == "cell"
+        assert integral["tensor_shape"] == [6] * integral["rank"]
+        assert integral["flops"] > 0
+        assert all(rule["num_points"] > 0 for rule in integral["quadrature_rules"])
+        assert all(table["bytes"] > 0 and table["type"] == "double" for table in integral["tables"])
+        assert integral["bytes_moved"]["arguments"]["store"] > 0
+    assert manifest["integrals"][1]["enabled_coefficients"] == [True]
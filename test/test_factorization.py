@@ -0,0 +1,52 @@
+# Copyright (C) 2022 FEniCS Project
+#
+# This file is part of FFCx. (https://www.fenicsproject.org)
+#
+# SPDX-License-Identifier:    LGPL-3.0-or-later
+
+import ffcx.ir.analysis.factorization as factorization
+import ffcx.options
+import ufl
+from ffcx.analysis import analyze_ufl_objects
+from ffcx.ir.analysis.graph import build_scalar_graph
+
+
+def test_memoised_factorization(monkeypatch):
+    # Jacobian of a hyperelastic energy, where the same pairs of factors
+    # are combined many times
+    cell = ufl.tetrahedron
+    element = ufl.VectorElement("Lagrange", cell, 1)
+    u = ufl.Coefficient(element)
+    v, w = ufl.TestFunction(element), ufl.TrialFunction(element)
+    F = ufl.Identity(3) + ufl.grad(u)
+    C = F.T * F
+    J = ufl.det(F)
+    psi = (ufl.tr(C) - 3) / 2 - ufl.ln(J) + ufl.ln(J)**2 / 2
+    a = ufl.derivative(ufl.derivative(psi * ufl.dx, u, v), u, w)
+
+    analysis = analyze_ufl_objects([a], ffcx.options.get_options())
+    integrand = analysis.form_data[0].integral_data[0].integrals[0].integrand()
+
+    def factorize():
+        S = build_scalar_graph(integrand)
+        return factorization.compute_argument_factorization(S, 2)
+
+    memoised = factorize()
+
+    # Without the memos every operation on factors builds a UFL
+    # expression and every product of monomials a new tuple
+    def graph_insert_operation(F, op, fi0, fi1):
+        return factorization.graph_insert(F, op(F.expressions[fi0], F.expressions[fi1]))
+
+    def monomial_product(F, m0, m1):
+        return factorization.monomial(F, tuple(sorted(F.monomials[m0] + F.monomials[m1])))
+
+    monkeypatch.setattr(factorization, "graph_insert_operation", graph_insert_operation)
+    monkeypatch.setattr(factorization, "monomial_product", monomial_product)
+    plain = factorize()
+
+    assert memoised.expressions == plain.expressions
+    assert memoised.target == plain.target
+    assert memoised.component == plain.component
+    assert [memoised.out_edges(i) for i in range(memoised.number_of_nodes())] == \
+        [plain.out_edges(i) for i in range(plain.number_of_nodes())]
@@ -5,8 +5,11 @@
 # SPDX-License-Identifier:    LGPL-3.0-or-later
 
 
+import collections
+
 import ufl
-from ffcx.codegeneration.flop_count import count_flops
+import ffcx.codegeneration.C.cnodes as L
+from ffcx.codegeneration.flop_count import count_flops, kernel_statistics
 
 
 def create_form(degree):
@@ -37,3 +40,58 @@ def test_flops():
     r = sum(flops_2, 0.) / sum(flops_1, 0.)
 
     assert r > (dofs2**2 / dofs1**2)
+
+
+def test_flops_conditional():
+    x = L.Symbol("x")
+    condition = L.LT(x, 0.0)
+    cheap = L.Mul(x, 2.0)
+    expensive = L.Add(L.Mul(x, x), L.Mul(x, 3.0))
+
+    # The condition and the more expensive branch are counted
+    assert L.Conditional(condition, expensive, cheap).flops() == 4
+    assert L.Conditional(condition, cheap, expensive).flops() == 4
+
+    mesh = ufl.Mesh(ufl.VectorElement("Lagrange", "triangle", 1))
+    V = ufl.FunctionSpace(mesh, ufl.FiniteElement("Lagrange", ufl.triangle, 1))
+    u, v = ufl.TrialFunction(V), ufl.TestFunction(V)
+    y = ufl.SpatialCoordinate(mesh)
+    a = ufl.inner(ufl.grad(u), ufl.grad(v)) * ufl.dx
+    a_conditional = ufl.conditional(ufl.lt(y[0], 0.5), 2.0, 1.0) * a
+    assert count_flops(a_conditional)[0] > count_flops(a)[0]
+
+
+def test_memory_accesses():
+    A, B, i = L.Symbol("A"), L.Symbol("B"), L.Symbol("i")
+    update = L.AssignAdd(L.ArrayAccess(A, i), L.ArrayAccess(B, i))
+    assert update.memory_accesses() == collections.Counter(
+        {("A", "store"): 1, ("A", "load"): 1, ("B", "load"): 1})
+
+    # Arrays that are not a symbol are counted under their C code
+    access = L.ArrayAccess(B, 0)
+    access.array = L.Add(B, 4)
+    assert access.memory_accesses() == collections.Counter({("B + 4", "load"): 1})
+    update = L.Assign(access, 1.0)
+    assert update.memory_accesses() == collections.Counter({("B + 4", "store"): 1})
+
+
+def test_kernel_statistics():
+    a = create_form(2)
+    statistics = kernel_statistics(a, machine_balance=1e6)
+    assert len(statistics) == 2
+    assert [s["flops"] for s in statistics] == count_flops(a)
+
+    for s in statistics:
+        # Every kernel reads the geometry and writes the element tensor
+        assert s["bytes"]["arguments"]["load"] > 0
+        assert s["bytes"]["arguments"]["store"] > 0
+        # Tables are never written
+        assert s["bytes"]["tables"]["store"] == 0
+        assert s["total_bytes"] == sum(b["load"] + b["store"] for b in s["bytes"].values())
+        assert s["arithmetic_intensity"] == s["flops"] / s["total_bytes"]
+        assert s["bound"] == "memory"
+
+    # Single precision halves the traffic of the arguments
+    statistics_float = kernel_statistics(a, {"scalar_type": "float"})
+    for s, s_float in zip(statistics, statistics_float):
+        assert s_float["bytes"]["arguments"]["store"] * 2 == s["bytes"]["arguments"]["store"]
@@ -0,0 +1,61 @@
+# Copyright (C) 2022 FEniCS Project
+#
+# This file is part of FFCx. (https://www.fenicsproject.org)
+#
+# SPDX-License-Identifier:    LGPL-3.0-or-later
+
+import pytest
+
+import ufl
+from ffcx.ir.analysis.graph import (ExpressionGraph, build_scalar_graph,
+                                    propagate_zeros)
+
+
+def test_edges_keep_insertion_order():
+    G = ExpressionGraph()
+    for e in "abcde":
+        G.add_node(e)
+    for i, j in [(2, 0), (2, 1), (2, 0), (3, 2), (4, 3), (4, 1)]:
+        G.add_edge(i, j)
+
+    assert [G.out_edges(i) for i in range(5)] == [[], [], [0, 1, 0], [2], [3, 1]]
+    assert [G.in_edges(i) for i in range(5)] == [[2, 2], [2, 4], [3], [4], []]
+
+    # Edges added after the first query are picked up
+    G.add_edge(G.add_node("f"), 4)
+    assert G.in_edges(4) == [5]
+
+    with pytest.raises(KeyError):
+        G.add_edge(0, 10)
+
+
+def test_scalar_graph_edges():
+    element = ufl.VectorElement("Lagrange", ufl.triangle, 1)
+    u, v = ufl.TrialFunction(element), ufl.TestFunction(element)
+    S = build_scalar_graph(ufl.inner(ufl.grad(u), ufl.grad(v)))
+
+    assert S.number_of_nodes() == len(S.e2i)
+    for i, expr in enumerate(S.expressions):
+        assert S.e2i[expr] == i
+        if expr._ufl_is_terminal_ or expr._ufl_is_terminal_modifier_:
+            assert S.out_edges(i) == []
+        else:
+            assert S.out_edges(i) == [S.e2i[o] for o in expr.ufl_operands if S.e2i[o] != i]
+            for j in S.out_edges(i):
+                assert i in S.in_edges(j)
+    assert sorted(S.target) == [S.number_of_nodes() - 1]
+
+
+def test_propagate_zeros():
+    element = ufl.FiniteElement("Lagrange", ufl.triangle, 1)
+    u, v = ufl.TrialFunction(element), ufl.TestFunction(element)
+    f = ufl.Coefficient(element)
+    S = build_scalar_graph(u * v + f * v)
+
+    G = propagate_zeros(S, {S.e2i[f]})
+    assert f not in G.e2i
+    assert G.number_of_nodes() == 3
+    target, = G.target
+    assert G.expressions[target] == u * v
+    assert G.component[target] == [0]
+    assert sorted(G.out_edges(target)) == sorted([G.e2i[u], G.e2i[v]])
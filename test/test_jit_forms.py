@@ -4,12 +4,19 @@
 #
 # SPDX-License-Identifier:    LGPL-3.0-or-later
 
+import json
+import platform
+
 import numpy as np
 import pytest
 import sympy
 from sympy.abc import x, y, z
 
+import ffcx.analysis
 import ffcx.codegeneration.jit
+import ffcx.compiler
+import ffcx.ir.representation
+import ffcx.options
 import ufl
 from ffcx.naming import cdtype_to_numpy, scalar_to_value_type
 
@@ -721,3 +728,405 @@ def test_complex_operations(compile_args):
     assert np.allclose(J_2, expected_result)
 
     assert np.allclose(J_1, J_2)
+
+
+P1_LAPLACE_MATRIX = np.array([[1.0, -0.5, -0.5], [-0.5, 0.5, 0.0], [-0.5, 0.0, 0.5]])
+
+
+def _p1_laplace_form():
+    element = ufl.FiniteElement("Lagrange", ufl.triangle, 1)
+    u, v = ufl.TrialFunction(element), ufl.TestFunction(element)
+    return ufl.inner(ufl.grad(u), ufl.grad(v)) * ufl.dx
+
+
+def _tabulate_p1_laplace(compiled_forms, module, mode="double", calls=1):
+    """Tabulate the cell integral of a P1 Laplace form on the reference triangle."""
+    ffi = module.ffi
+    default_integral = compiled_forms[0].integrals(module.lib.cell)[0]
+
+    np_type = cdtype_to_numpy(mode)
+    A = np.zeros((3, 3), dtype=np_type)
+    w = np.array([], dtype=np_type)
+    c = np.array([], dtype=np_type)
+
+    geom_type = scalar_to_value_type(mode)
+    coords = np.array([[0.0, 0.0, 0.0],
+                       [1.0, 0.0, 0.0],
+                       [0.0, 1.0, 0.0]], dtype=cdtype_to_numpy(geom_type))
+
+    kernel = getattr(default_integral, f"tabulate_tensor_{np_type}")
+    for _ in range(calls):
+        kernel(ffi.cast(f'{mode} *', A.ctypes.data), ffi.cast(f'{mode} *', w.ctypes.data),
+               ffi.cast(f'{mode} *', c.ctypes.data), ffi.cast(f'{geom_type} *', coords.ctypes.data),
+               ffi.NULL, ffi.NULL)
+    return A
+
+
+@pytest.mark.parametrize("options,kwargs", [
+    ({}, {"backend": "direct"}),
+    ({"scalar_type": "double _Complex"}, {"backend": "direct"}),
+    ({}, {"tiered": True}),
+    pytest.param({"target_clones": "avx2,avx512f"}, {},
+                 marks=pytest.mark.skipif(platform.machine() != "x86_64", reason="x86-64 instruction set targets")),
+    ({"instrument_kernels": True}, {}),
+    ({}, {"backend": "direct", "pgo": True}),
+], ids=["direct", "direct-complex", "tiered", "target_clones", "instrument_kernels", "pgo"])
+def test_jit_variants(options, kwargs, compile_args, tmp_path):
+    compiled_forms, module, code = ffcx.codegeneration.jit.compile_forms(
+        [_p1_laplace_form()], options=options, cache_dir=tmp_path, cffi_extra_compile_args=compile_args, **kwargs)
+    assert compiled_forms[0].rank == 2
+
+    A = _tabulate_p1_laplace(compiled_forms, module, options.get("scalar_type", "double"))
+    assert np.allclose(A, P1_LAPLACE_MATRIX)
+
+    # Background builds write to the cache directory
+    assert ffcx.codegeneration.jit.wait_for_background_builds() == 0
+
+
+def test_direct_backend(compile_args, tmp_path):
+    modules = []
+    for _ in range(2):
+        # Second pass loads the shared library from the cache
+        _, module, _ = ffcx.codegeneration.jit.compile_forms(
+            [_p1_laplace_form()], cache_dir=tmp_path, cffi_extra_compile_args=compile_args, backend="direct")
+        assert module.__file__.endswith(".so")
+        modules.append(module.__name__)
+    assert modules[0] == modules[1]
+
+
+def test_tiered(compile_args, tmp_path):
+    forms = [_p1_laplace_form()]
+
+    _, optimised, _ = ffcx.codegeneration.jit.compile_forms(
+        forms, cache_dir=tmp_path / "reference", cffi_extra_compile_args=compile_args)
+
+    # First call returns the quick build, the optimised one is built in the background
+    _, quick, _ = ffcx.codegeneration.jit.compile_forms(
+        forms, cache_dir=tmp_path, cffi_extra_compile_args=compile_args, tiered=True)
+    assert quick.__name__ != optimised.__name__
+
+    assert ffcx.codegeneration.jit.wait_for_background_builds() == 0
+
+    compiled_forms, module, _ = ffcx.codegeneration.jit.compile_forms(
+        forms, cache_dir=tmp_path, cffi_extra_compile_args=compile_args, tiered=True)
+    assert module.__name__ == optimised.__name__
+    assert compiled_forms[0].rank == 2
+
+
+def test_compile_forms_async(compile_args, tmp_path):
+    element = ufl.FiniteElement("Lagrange", ufl.triangle, 1)
+    u, v = ufl.TrialFunction(element), ufl.TestFunction(element)
+    a = ufl.inner(ufl.grad(u), ufl.grad(v)) * ufl.dx
+    L = v * ufl.dx
+
+    fa = ffcx.codegeneration.jit.compile_forms_async([a], cache_dir=tmp_path, cffi_extra_compile_args=compile_args)
+    fa_again = ffcx.codegeneration.jit.compile_forms_async([a], cache_dir=tmp_path,
+                                                           cffi_extra_compile_args=compile_args)
+    fL = ffcx.codegeneration.jit.compile_forms_async([L], cache_dir=tmp_path, cffi_extra_compile_args=compile_args)
+
+    # In-flight requests for the same module are shared
+    assert fa is fa_again
+    assert fa is not fL
+
+    # Tuned and profile-guided modules are not named by the signature
+    for kwargs in ({"tune": True}, {"pgo": True, "backend": "direct"}, {"tiered": True}):
+        with pytest.raises(ValueError):
+            ffcx.codegeneration.jit.compile_forms_async([a], cache_dir=tmp_path, **kwargs)
+
+    compiled_forms, module, code = fa.result()
+    assert compiled_forms[0].rank == 2
+    compiled_forms, module, code = fL.result()
+    assert compiled_forms[0].rank == 1
+
+
+@pytest.mark.skipif(platform.machine() != "x86_64", reason="x86-64 instruction set targets")
+def test_target_clones():
+    a = _p1_laplace_form()
+    options = ffcx.options.get_options({"target_clones": "avx2,avx512f"})
+    code = ffcx.compiler.compile_ufl_objects([a], options=options)
+    assert 'target_clones("avx2", "avx512f", "default")' in code[1]
+
+    # Targets are checked before they are pasted into the attribute
+    with pytest.raises(ValueError, match="Invalid target"):
+        ffcx.compiler.compile_ufl_objects([a], options=ffcx.options.get_options({"target_clones": 'avx2")'}))
+
+
+def test_instrument_kernels(compile_args):
+    a = _p1_laplace_form()
+
+    compiled_forms, module, code = ffcx.codegeneration.jit.compile_forms(
+        [a], cffi_extra_compile_args=compile_args)
+    assert compiled_forms[0].integrals(module.lib.cell)[0].statistics == module.ffi.NULL
+
+    compiled_forms, module, code = ffcx.codegeneration.jit.compile_forms(
+        [a], options={"instrument_kernels": True}, cffi_extra_compile_args=compile_args)
+    statistics = compiled_forms[0].integrals(module.lib.cell)[0].statistics
+    assert statistics.num_calls == 0
+
+    A = _tabulate_p1_laplace(compiled_forms, module, calls=3)
+    assert np.allclose(A, 3 * P1_LAPLACE_MATRIX)
+    assert statistics.num_calls == 3
+    assert statistics.time_ns >= 0
+
+    # The counters can be reset by the caller
+    statistics.num_calls = 0
+    statistics.time_ns = 0
+
+
+def test_integral_sizes_and_costs(compile_args):
+    element = ufl.FiniteElement("Lagrange", ufl.triangle, 1)
+    u, v = ufl.TrialFunction(element), ufl.TestFunction(element)
+    f = ufl.Coefficient(ufl.FiniteElement("Lagrange", ufl.triangle, 2))
+    kappa = ufl.Constant(ufl.triangle, shape=(2, 2))
+    a = kappa[0, 0] * f * u * v * ufl.dx + ufl.avg(f) * ufl.jump(u) * ufl.jump(v) * ufl.dS
+
+    compiled_forms, module, code = ffcx.codegeneration.jit.compile_forms(
+        [a], cffi_extra_compile_args=compile_args)
+    form = compiled_forms[0]
+
+    cell_integral = form.integrals(module.lib.cell)[0]
+    assert cell_integral.rank == 2
+    assert [cell_integral.tensor_shape[i] for i in range(2)] == [3, 3]
+    assert cell_integral.num_coefficient_values == 6
+    assert cell_integral.num_constant_values == 4
+    assert cell_integral.num_coordinate_dofs == 3
+    assert cell_integral.flops > 0
+    assert cell_integral.scratch_bytes >= 0
+
+    facet_integral = form.integrals(module.lib.interior_facet)[0]
+    assert [facet_integral.tensor_shape[i] for i in range(2)] == [6, 6]
+    assert facet_integral.num_coefficient_values == 12
+    assert facet_integral.num_coordinate_dofs == 3
+
+
+@pytest.mark.parametrize("compensated", [False, True])
+def test_tabulate_functional(compile_args, compensated):
+    element = ufl.FiniteElement("Lagrange", ufl.triangle, 1)
+    f = ufl.Coefficient(element)
+    u, v = ufl.TrialFunction(element), ufl.TestFunction(element)
+    M = f * f * ufl.dx
+    a = u * v * ufl.dx
+
+    compiled_forms, module, code = ffcx.codegeneration.jit.compile_forms([M], cffi_extra_compile_args=compile_args)
+    assert compiled_forms[0].integrals(module.lib.cell)[0].tabulate_functional_float64 == module.ffi.NULL
+
+    compiled_forms, module, code = ffcx.codegeneration.jit.compile_forms(
+        [M, a], options={"tabulate_functional": True, "functional_compensated_summation": compensated},
+        cffi_extra_compile_args=compile_args)
+    ffi = module.ffi
+    integral = compiled_forms[0].integrals(module.lib.cell)[0]
+    assert compiled_forms[1].integrals(module.lib.cell)[0].tabulate_functional_float64 == ffi.NULL
+
+    num_cells = 6
+    w = np.arange(3 * num_cells, dtype=np.float64)
+    c = np.array([], dtype=np.float64)
+    coords = np.tile(np.array([0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 1.0, 0.0]), num_cells)
+    coords[9::9] -= np.arange(1, num_cells)
+
+    expected = np.zeros(1)
+    for i in range(num_cells):
+        integral.tabulate_tensor_float64(
+            ffi.cast('double *', expected.ctypes.data), ffi.cast('double *', w[3 * i:].ctypes.data),
+            ffi.cast('double *', c.ctypes.data), ffi.cast('double *', coords[9 * i:].ctypes.data), ffi.NULL, ffi.NULL)
+
+    # The batched kernel adds the sum over all cells to the result
+    result = np.ones(1)
+    integral.tabulate_functional_float64(
+        ffi.cast('double *', result.ctypes.data), num_cells, ffi.cast('double *', w.ctypes.data),
+        ffi.cast('double *', c.ctypes.data), ffi.cast('double *', coords.ctypes.data), ffi.NULL, ffi.NULL)
+    assert np.isclose(result[0], 1.0 + expected[0])
+
+
+@pytest.mark.parametrize("mode", ["double", "double _Complex"])
+def test_tabulate_action(compile_args, mode):
+    element = ufl.VectorElement("Lagrange", ufl.triangle, 2)
+    f = ufl.Coefficient(ufl.FiniteElement("Lagrange", ufl.triangle, 1))
+    u, v = ufl.TrialFunction(element), ufl.TestFunction(element)
+    a = ufl.inner(ufl.grad(u), ufl.grad(v)) * ufl.dx + f * ufl.inner(u, v) * ufl.dx + u[0] * v[1] * ufl.ds
+    L = f * v[0] * ufl.dx
+
+    np_type = cdtype_to_numpy(mode)
+    geom_type = scalar_to_value_type(mode)
+
+    compiled_forms, module, code = ffcx.codegeneration.jit.compile_forms(
+        [a], options={"scalar_type": mode}, cffi_extra_compile_args=compile_args)
+    assert getattr(compiled_forms[0].integrals(module.lib.cell)[0], f"tabulate_action_{np_type}") == module.ffi.NULL
+
+    compiled_forms, module, code = ffcx.codegeneration.jit.compile_forms(
+        [a, L], options={"scalar_type": mode, "tabulate_action": True}, cffi_extra_compile_args=compile_args)
+    ffi = module.ffi
+    assert getattr(compiled_forms[1].integrals(module.lib.cell)[0], f"tabulate_action_{np_type}") == ffi.NULL
+
+    w = np.array([1.0, 2.0, 3.0], dtype=np_type)
+    c = np.array([], dtype=np_type)
+    coords = np.array([0.0, 0.0, 0.0, 2.0, 0.0, 0.0, 0.5, 1.0, 0.0], dtype=cdtype_to_numpy(geom_type))
+    facet = np.array([1], dtype=np.intc)
+    num_vectors = 3
+    x = np.random.default_rng(0).random((num_vectors, 12)).astype(np_type)
+
+    for integral_type in (module.lib.cell, module.lib.exterior_facet):
+        integral = compiled_forms[0].integrals(integral_type)[0]
+        args = (ffi.cast(f'{mode} *', w.ctypes.data), ffi.cast(f'{mode} *', c.ctypes.data),
+                ffi.cast(f'{geom_type} *', coords.ctypes.data), ffi.cast('int *', facet.ctypes.data), ffi.NULL)
+
+        A = np.zeros((12, 12), dtype=np_type)
+        getattr(integral, f"tabulate_tensor_{np_type}")(ffi.cast(f'{mode} *', A.ctypes.data), *args)
+
+        # The action is added to y, for each vector
+        y = np.ones((num_vectors, 12), dtype=np_type)
+        getattr(integral, f"tabulate_action_{np_type}")(
+            ffi.cast(f'{mode} *', y.ctypes.data), num_vectors, ffi.cast(f'{mode} *', x.ctypes.data), *args)
+        assert np.allclose(y, 1.0 + x @ A.T)
+
+
+def test_tabulate_action_piecewise(compile_args):
+    # Blocks with piecewise constant tables (DG0 test function, gradient
+    # of P1 on an affine cell) and piecewise factors
+    P1 = ufl.FiniteElement("Lagrange", ufl.triangle, 1)
+    DG0 = ufl.FiniteElement("DG", ufl.triangle, 0)
+    u, q = ufl.TrialFunction(P1), ufl.TestFunction(DG0)
+    k = ufl.Coefficient(DG0)
+    a = q * u.dx(0) * ufl.dx + k * q * u.dx(1) * ufl.dx + k * q * u * ufl.dx
+
+    compiled_forms, module, code = ffcx.codegeneration.jit.compile_forms(
+        [a], options={"tabulate_action": True}, cffi_extra_compile_args=compile_args)
+    ffi = module.ffi
+    integral = compiled_forms[0].integrals(module.lib.cell)[0]
+
+    w = np.array([3.0], dtype=np.float64)
+    c = np.array([], dtype=np.float64)
+    coords = np.array([0.0, 0.0, 0.0, 2.0, 0.0, 0.0, 0.5, 1.0, 0.0], dtype=np.float64)
+    args = (ffi.cast('double *', w.ctypes.data), ffi.cast('double *', c.ctypes.data),
+            ffi.cast('double *', coords.ctypes.data), ffi.NULL, ffi.NULL)
+
+    A = np.zeros((1, 3), dtype=np.float64)
+    integral.tabulate_tensor_float64(ffi.cast('double *', A.ctypes.data), *args)
+    x = np.random.default_rng(0).random((2, 3))
+    y = np.zeros((2, 1), dtype=np.float64)
+    integral.tabulate_action_float64(ffi.cast('double *', y.ctypes.data), 2, ffi.cast('double *', x.ctypes.data),
+                                     *args)
+    assert np.allclose(y, x @ A.T)
+
+
+def test_tune(compile_args, tmp_path, monkeypatch):
+    element = ufl.FiniteElement("Lagrange", ufl.triangle, 2)
+    u, v = ufl.TrialFunction(element), ufl.TestFunction(element)
+    a = ufl.inner(ufl.grad(u), ufl.grad(v)) * ufl.dx + u * v * ufl.ds
+
+    variants = [{"padlen": 1}, {"padlen": 8}]
+    compiled_forms, module, code = ffcx.codegeneration.jit.compile_forms(
+        [a], cache_dir=tmp_path, cffi_extra_compile_args=compile_args, tune=variants)
+    assert compiled_forms[0].rank == 2
+
+    tuning_files = list(tmp_path.glob("libffcx_tuning_*.json"))
+    assert len(tuning_files) == 1
+    decision = json.loads(tuning_files[0].read_text())
+    assert [r["options"] for r in decision["variants"]] == variants
+    assert all(r["seconds_per_call"] > 0 for r in decision["variants"])
+    assert decision["options"] in variants
+
+    # The stored decision is reused without timing the variants again
+    def fail(*args):
+        raise AssertionError("variants timed again")
+    monkeypatch.setattr(ffcx.codegeneration.jit, "_time_forms", fail)
+    compiled_forms, module_again, code = ffcx.codegeneration.jit.compile_forms(
+        [a], cache_dir=tmp_path, cffi_extra_compile_args=compile_args, tune=variants)
+    assert module_again.__name__ == module.__name__
+
+
+def test_pgo(compile_args, tmp_path):
+    a = _p1_laplace_form()
+
+    with pytest.raises(ValueError):
+        ffcx.codegeneration.jit.compile_forms([a], cache_dir=tmp_path, pgo=True)
+    with pytest.raises(ValueError):
+        ffcx.codegeneration.jit.compile_forms([a], cache_dir=tmp_path, backend="direct", pgo=lambda f, m: None)
+
+    _, plain_module, _ = ffcx.codegeneration.jit.compile_forms(
+        [a], cache_dir=tmp_path, cffi_extra_compile_args=compile_args, backend="direct")
+
+    warmed_up = []
+
+    def warm_up(compiled_forms, module):
+        warmed_up.append(compiled_forms[0].rank)
+
+    module_names = set()
+    for pgo in (True, ("warm_up", warm_up)):
+        compiled_forms, module, code = ffcx.codegeneration.jit.compile_forms(
+            [a], cache_dir=tmp_path, cffi_extra_compile_args=compile_args, backend="direct", pgo=pgo)
+        module_names.add(module.__name__)
+        assert module.__name__ != plain_module.__name__
+        assert not list(tmp_path.glob("*.profile"))
+    assert warmed_up == [2]
+    assert len(module_names) == 2
+    assert np.allclose(_tabulate_p1_laplace(compiled_forms, module), P1_LAPLACE_MATRIX)
+
+
+def test_parallel_ir(compile_args, monkeypatch):
+    element = ufl.FiniteElement("Lagrange", ufl.triangle, 2)
+    u, v = ufl.TrialFunction(element), ufl.TestFunction(element)
+    a = sum(ufl.inner(ufl.grad(u), ufl.grad(v)) * ufl.dx(i) for i in range(4)) + u * v * ufl.ds
+
+    def code(workers):
+        _, code_c = ffcx.compiler.compile_ufl_objects(
+            [a], options=ffcx.options.get_options({"ir_workers": workers}))
+        return [line for line in code_c.splitlines() if not line.startswith("//")]
+
+    sequential = code(1)
+
+    # With several workers, no integral is computed in this process
+    def fail(*args):
+        raise AssertionError("IR computed sequentially")
+    monkeypatch.setattr(ffcx.ir.representation, "_compute_integral_ir_region", fail)
+    assert code(3) == sequential
+    monkeypatch.undo()
+
+    # The number of workers does not affect the JIT module name
+    _, module1, _ = ffcx.codegeneration.jit.compile_forms(
+        [a], options={"ir_workers": 1}, cffi_extra_compile_args=compile_args)
+    _, module2, _ = ffcx.codegeneration.jit.compile_forms(
+        [a], options={"ir_workers": 2}, cffi_extra_compile_args=compile_args)
+    assert module1.__name__ == module2.__name__
+
+
+def test_form_data_cache():
+    element = ufl.FiniteElement("Lagrange", ufl.triangle, 1)
+    u, v = ufl.TrialFunction(element), ufl.TestFunction(element)
+    f = ufl.Coefficient(element)
+    options = ffcx.options.get_options()
+
+    def form_data(form):
+        return ffcx.analysis.analyze_ufl_objects([form], options).form_data[0]
+
+    ffcx.analysis.clear_form_data_cache()
+    a = f * u * v * ufl.dx
+    fd = form_data(a)
+    assert form_data(a) is fd
+
+    # A new form with the same coefficient reuses the analysis
+    a2 = f * u * v * ufl.dx
+    fd2 = form_data(a2)
+    assert fd2.original_form is a2
+    assert fd2.integral_data is fd.integral_data
+
+    # A different coefficient with the same signature does not
+    g = ufl.Coefficient(element)
+    a3 = g * u * v * ufl.dx
+    assert a3.signature() == a.signature()
+    fd3 = form_data(a3)
+    assert fd3.original_form is a3
+    assert fd3.integral_data is not fd.integral_data
+
+
+def test_write_ufl_objects(tmp_path):
+    element = ufl.FiniteElement("Lagrange", ufl.triangle, 2)
+    u, v = ufl.TrialFunction(element), ufl.TestFunction(element)
+    f = ufl.Coefficient(element)
+    forms = [ufl.inner(ufl.grad(u), ufl.grad(v)) * ufl.dx, f * v * ufl.dx + f * v * ufl.ds]
+
+    options = ffcx.options.get_options()
+    code_h, code_c = ffcx.compiler.compile_ufl_objects(forms, prefix="streamed", options=options)
+    ffcx.compiler.write_ufl_objects(forms, str(tmp_path), prefix="streamed", options=options)
+    assert tmp_path.joinpath("streamed.h").read_text() == code_h
+    assert tmp_path.joinpath("streamed.c").read_text() == code_c
+    assert sorted(p.name for p in tmp_path.iterdir()) == ["streamed.c", "streamed.h"]